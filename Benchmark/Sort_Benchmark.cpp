@@ -0,0 +1,276 @@
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+
+// -------------------------------------------------------------------------------------
+// Benchmark for the sort engines in Sort.h over different sizes, distributions and
+// element types. Every measurement is one CSV line on stdout:
+//
+// engine,type,distribution,size,repetitions,median_ns,ns_per_element
+//
+// Build (the parallel algorithms need TBB with libstdc++):
+// g++ -std=c++17 -O2 -DNDEBUG Benchmark/Sort_Benchmark.cpp -o sort_benchmark -ltbb
+// cl /std:c++17 /O2 /EHsc /DNDEBUG Benchmark\Sort_Benchmark.cpp
+//
+// Usage:
+// sort_benchmark [max_size = 16777216] [min_size = 16]
+// The sizes grow by a factor of 4, max_size can go up to 10^9 (memory permitting).
+// -------------------------------------------------------------------------------------
+
+
+
+#include "../Sort.h"
+#include "../Types.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace jul::types;
+
+namespace {
+
+    // insertion sort is O(n²) on unsorted input, don't wait for hours
+    constexpr std::size_t Max_Quadratic_Size = 1 << 14;
+
+    // the swaps of Distribution::Almost_Sorted move a value at most this far
+    constexpr std::size_t Almost_Sorted_Window = 8;
+
+    // repeat small sizes until roughly this many elements were sorted
+    constexpr std::size_t Elements_Per_Measurement = 1 << 22;
+    constexpr std::size_t Max_Repetitions = 101;
+
+
+
+    // a payload heavy record, sorted by its key
+    struct Record {
+        u64  key;
+        char payload[192];
+
+        bool operator<(const Record& other) const { return key < other.key; }
+    };
+
+
+
+    template <class T> T    from_u64(u64 n) { return static_cast<T>(n); }
+    template <>        Record from_u64(u64 n) { Record r{}; r.key = n; return r; }
+
+    // results of the measured runs go here, so the optimizer can not drop a run
+    volatile u64 g_sink = 0;
+
+    template <class T> u64  sink_key(const T& value)  { return static_cast<u64>(value); }
+    template <>        u64  sink_key(const Record& r) { return r.key; }
+
+    void sink(u64 n) { g_sink = g_sink + n; }
+
+
+
+    template <class T> const char* type_name();
+    template <> const char* type_name<i32>()    { return "i32"; }
+    template <> const char* type_name<u64>()    { return "u64"; }
+    template <> const char* type_name<f64>()    { return "f64"; }
+    template <> const char* type_name<Record>() { return "record200"; }
+
+
+
+    enum class Distribution {
+        Random,
+        Sorted,
+        Reversed,
+        Few_Unique,
+        Organ_Pipe,
+        Almost_Sorted
+    };
+
+    const char* to_string(Distribution d)
+    {
+        switch (d) {
+        case Distribution::Random:        return "random";
+        case Distribution::Sorted:        return "sorted";
+        case Distribution::Reversed:      return "reversed";
+        case Distribution::Few_Unique:    return "few_unique";
+        case Distribution::Organ_Pipe:    return "organ_pipe";
+        case Distribution::Almost_Sorted: return "almost_sorted";
+        }
+        return "";
+    }
+
+    // inputs on which insertion sort stays (nearly) linear at any size
+    bool is_presorted(Distribution d)
+    {
+        return d == Distribution::Sorted || d == Distribution::Almost_Sorted;
+    }
+
+
+
+    template <class T>
+    std::vector<T> make_input(Distribution d, std::size_t size)
+    {
+        std::mt19937_64 rng{ 42 };
+        std::vector<T> values(size);
+
+        for (std::size_t n = 0; n < size; ++n) {
+            u64 key = 0;
+            switch (d) {
+            case Distribution::Random:        key = rng() >> 34; break;
+            case Distribution::Sorted:        key = n; break;
+            case Distribution::Reversed:      key = size - n; break;
+            case Distribution::Few_Unique:    key = rng() % 16; break;
+            case Distribution::Organ_Pipe:    key = n < size / 2 ? n : size - n; break;
+            case Distribution::Almost_Sorted: key = n; break;
+            }
+            values[n] = from_u64<T>(key);
+        }
+
+        // ~1% swaps with a neighbour at most Almost_Sorted_Window away: every value stays
+        // close to its place, so insertion sort is still linear (see is_presorted)
+        if (d == Distribution::Almost_Sorted && size > Almost_Sorted_Window) {
+            for (std::size_t n = 0; n < size / 100 + 1; ++n) {
+                const std::size_t first = rng() % (size - Almost_Sorted_Window);
+                std::swap(values[first], values[first + 1 + rng() % Almost_Sorted_Window]);
+            }
+        }
+
+        return values;
+    }
+
+
+
+    struct Engine {
+        const char* name;
+        bool        quadratic;
+        std::function<void(void*)> run; // gets a std::vector<T>*
+    };
+
+    template <class T>
+    std::vector<Engine> make_engines()
+    {
+        auto vec = [](void* p) -> std::vector<T>& { return *static_cast<std::vector<T>*>(p); };
+
+        std::vector<Engine> engines = {
+            { "insertion_sort", true,  [=](void* p) { jul::insertion_sort(vec(p)); } },
+            { "std_sort",       false, [=](void* p) { std::sort(std::begin(vec(p)), std::end(vec(p))); } },
+            { "jul_sort",       false, [=](void* p) { jul::sort(vec(p)); } },
+            { "jul_sort_par",   false, [=](void* p) { jul::sort(std::execution::par, vec(p)); } },
+            { "jul_sort_on",    false, [=](void* p) { jul::Default_Scheduler s; jul::sort_on(s, vec(p)); } },
+            { "top_k_100",      false, [=](void* p) {
+                const auto best = jul::top_k(vec(p), 100, std::less<>{});
+                if (!best.empty()) sink(sink_key(best.front()));
+            } },
+            { "nth_median",     false, [=](void* p) { if (!vec(p).empty()) sink(sink_key(jul::nth(vec(p), std::size(vec(p)) / 2))); } },
+        };
+
+        if constexpr (std::is_arithmetic<T>::value) {
+            engines.push_back({ "argsort", false, [=](void* p) {
+                auto order = jul::argsort(vec(p));
+                jul::apply_permutation(order, vec(p));
+                if (!vec(p).empty()) sink(sink_key(vec(p).front()));
+            } });
+        }
+        else {
+            engines.push_back({ "argsort_by_key", false, [=](void* p) {
+                auto order = jul::argsort_by(vec(p), [](const T& r) { return r.key; });
+                jul::apply_permutation(order, vec(p));
+                if (!vec(p).empty()) sink(sink_key(vec(p).front()));
+            } });
+        }
+
+        return engines;
+    }
+
+
+
+    template <class T>
+    void run_type(std::size_t min_size, std::size_t max_size)
+    {
+        using Clock = std::chrono::steady_clock;
+
+        const Distribution distributions[] = {
+            Distribution::Random, Distribution::Sorted, Distribution::Reversed,
+            Distribution::Few_Unique, Distribution::Organ_Pipe, Distribution::Almost_Sorted
+        };
+
+        for (auto d : distributions) {
+            for (std::size_t size = min_size; size <= max_size; size *= 4) {
+                const auto input = make_input<T>(d, size);
+
+                for (const auto& engine : make_engines<T>()) {
+                    if (engine.quadratic && size > Max_Quadratic_Size && !is_presorted(d)) {
+                        continue;
+                    }
+
+                    const std::size_t repetitions = std::clamp<std::size_t>(Elements_Per_Measurement / size, 1, Max_Repetitions);
+                    std::vector<long long> timings;
+                    timings.reserve(repetitions);
+
+                    for (std::size_t r = 0; r < repetitions; ++r) {
+                        auto values = input;
+                        const auto start = Clock::now();
+                        engine.run(&values);
+                        const auto end = Clock::now();
+                        timings.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+                    }
+
+                    std::nth_element(std::begin(timings), std::begin(timings) + repetitions / 2, std::end(timings));
+                    const auto median = timings[repetitions / 2];
+
+                    std::printf("%s,%s,%s,%zu,%zu,%lld,%.3f\n",
+                        engine.name, type_name<T>(), to_string(d), size, repetitions,
+                        median, static_cast<double>(median) / static_cast<double>(size));
+                    std::fflush(stdout);
+                }
+
+                if (size > max_size / 4) break; // don't overflow on huge sizes
+            }
+        }
+    }
+}
+
+
+
+int main(int argc, char** argv)
+{
+    const std::size_t max_size = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : std::size_t{ 1 } << 24;
+    const std::size_t min_size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16;
+
+    if (min_size == 0 || min_size > max_size) {
+        std::fprintf(stderr, "usage: %s [max_size] [min_size]\n", argv[0]);
+        return 1;
+    }
+
+    std::printf("engine,type,distribution,size,repetitions,median_ns,ns_per_element\n");
+
+    run_type<i32>(min_size, max_size);
+    run_type<u64>(min_size, max_size);
+    run_type<f64>(min_size, max_size);
+    run_type<Record>(min_size, max_size);
+
+    return 0;
+}
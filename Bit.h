@@ -25,8 +25,10 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 
 namespace jul 
 {
@@ -131,6 +133,41 @@ namespace jul
 
 
 
+    // -----------------------------------------------------------
+    // Is n a power of two?
+    // Example:
+    // assert(is_power_of_two(64) == true);
+    // assert(is_power_of_two(96) == false);
+    // -----------------------------------------------------------
+    template <class Integer>
+    constexpr bool is_power_of_two(Integer n)
+    {
+        return n > 0 && (n & (n - 1)) == 0;
+    }
+
+
+
+    // -----------------------------------------------------------
+    // Smallest power of two >= n (1 for n = 0), unsigned integers.
+    // Precondition: n <= the largest power of two of the type!
+    // Example:
+    // assert(next_power_of_two(5u)  == 8);
+    // assert(next_power_of_two(64u) == 64);
+    // -----------------------------------------------------------
+    template <class Unsigned>
+    constexpr Unsigned next_power_of_two(Unsigned n)
+    {
+        assert(n <= (Unsigned{ 1 } << (std::numeric_limits<Unsigned>::digits - 1)) && "No power of two of this type is that large!");
+
+        Unsigned power = 1;
+        while (power < n) {
+            power <<= 1;
+        }
+        return power;
+    }
+
+
+
 }
 
 #ifdef JUL_STATIC_TEST
@@ -162,6 +199,12 @@ static_assert(jul::how_many_bits(std::uint16_t{}) == 16);
 static_assert(jul::how_many_bits(std::uint32_t{}) == 32);
 static_assert(jul::how_many_bits(std::uint64_t{}) == 64);
 
+static_assert(jul::is_power_of_two(64) == true);
+static_assert(jul::is_power_of_two(96) == false);
+
+static_assert(jul::next_power_of_two(5u)  == 8);
+static_assert(jul::next_power_of_two(64u) == 64);
+
 #endif
 
 #endif // !JUL_BIT_H
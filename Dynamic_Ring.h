@@ -0,0 +1,240 @@
+#ifndef JUL_DYNAMIC_RING_H
+#define JUL_DYNAMIC_RING_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Bit.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------
+    // Span (class) = pointer and size of contiguous values (std::span
+    // is C++20). Does not own the values.
+    // ---------------------------------------------------------------
+    template <class T>
+    class Span {
+    public:
+        using value_type = std::remove_cv_t<T>;
+        using size_type  = std::size_t;
+        using iterator   = T*;
+
+        Span() = default;
+        Span(T* data, size_type size) : m_data{ data }, m_size{ size } {}
+
+        // Span<T> converts to Span<const T> (like T* to const T*)
+        template <class U, class = std::enable_if_t<!std::is_const<U>::value && std::is_same<const U, T>::value>>
+        Span(const Span<U>& other) : m_data{ other.data() }, m_size{ other.size() } {}
+
+        T*        data()  const { return m_data; }
+        size_type size()  const { return m_size; }
+        bool      empty() const { return m_size == 0; }
+
+        T& operator[](size_type n) const { assert(n < m_size); return m_data[n]; }
+
+        iterator begin() const { return m_data; }
+        iterator end()   const { return m_data + m_size; }
+
+    private:
+        T*        m_data = nullptr;
+        size_type m_size = 0;
+    };
+
+
+
+    // ---------------------------------------------------------------
+    // Dynamic_Ring (class) = circular buffer with a capacity chosen at
+    // runtime (rounded up to a power of two, indices are masked).
+    // When it is full, a push overwrites the oldest value.
+    // Iterates from the oldest to the newest value. spans() returns the
+    // same order as at most two contiguous blocks, ready for memcpy or
+    // writev. The storage comes from Allocator (e.g. a pmr arena).
+    // Example:
+    // Dynamic_Ring<Event> history(config.history_size);
+    // history.push(event);
+    // auto [older, newer] = history.spans();
+    // file.write(older.data(), older.size() * sizeof(Event));
+    // file.write(newer.data(), newer.size() * sizeof(Event));
+    // ---------------------------------------------------------------
+    template <class T, class Allocator = std::allocator<T>>
+    class Dynamic_Ring {
+    public:
+
+        // member types
+        using value_type      = T;
+        using size_type       = std::size_t;
+        using reference       = value_type&;
+        using const_reference = const value_type&;
+        using allocator_type  = Allocator;
+
+        // chronological iterator (oldest to newest)
+        template <class Owner, class Reference>
+        class Ring_Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = std::remove_reference_t<Reference>*;
+            using reference         = Reference;
+
+            Ring_Iterator() = default;
+            Ring_Iterator(Owner* owner, size_type n) : m_owner{ owner }, m_n{ n } {}
+
+            reference operator*()  const { return (*m_owner)[m_n]; }
+            pointer   operator->() const { return &(*m_owner)[m_n]; }
+
+            Ring_Iterator& operator++()    { ++m_n; return *this; }
+            Ring_Iterator  operator++(int) { auto copy = *this; ++m_n; return copy; }
+
+            bool operator==(const Ring_Iterator& other) const { return m_n == other.m_n; }
+            bool operator!=(const Ring_Iterator& other) const { return m_n != other.m_n; }
+
+        private:
+            Owner*    m_owner = nullptr;
+            size_type m_n     = 0;
+        };
+
+        using iterator       = Ring_Iterator<Dynamic_Ring, reference>;
+        using const_iterator = Ring_Iterator<const Dynamic_Ring, const_reference>;
+
+        // constructor: room for at least min_capacity values
+        explicit Dynamic_Ring(size_type min_capacity, const Allocator& allocator = Allocator()) :
+            m_buffer(next_power_of_two(std::max<size_type>(min_capacity, 1)), allocator),
+            m_mask{ std::size(m_buffer) - 1 }
+        {}
+
+        // push a value, true: the oldest value was overwritten
+        bool push(const T& value) { return emplace(value); }
+        bool push(T&& value)      { return emplace(std::move(value)); }
+
+        template <class... Args>
+        bool emplace(Args&&... args)
+        {
+            m_buffer[m_pushed & m_mask] = T(std::forward<Args>(args)...);
+            ++m_pushed;
+
+            if (m_size == capacity()) return true;
+            ++m_size;
+            return false;
+        }
+
+        // Pushes count values with at most two block copies. Returns how many values
+        // left the ring (overwritten old values and inputs beyond the capacity).
+        size_type push(const T* values, size_type count)
+        {
+            const size_type left = std::max(m_size + count, capacity()) - capacity();
+
+            if (count > capacity()) {
+                values += count - capacity();
+                count   = capacity();
+            }
+
+            const size_type first = m_pushed & m_mask;
+            const size_type split = std::min(count, capacity() - first);
+            std::copy(values, values + split, std::begin(m_buffer) + first);
+            std::copy(values + split, values + count, std::begin(m_buffer));
+
+            m_pushed += count;
+            m_size    = std::min(m_size + count, capacity());
+            return left;
+        }
+
+        size_type push(Span<const T> values) { return push(values.data(), values.size()); }
+
+        // n-th value from the oldest (0) to the newest (size() - 1)
+        reference       operator[](size_type n)       { assert(n < m_size); return m_buffer[(m_pushed - m_size + n) & m_mask]; }
+        const_reference operator[](size_type n) const { assert(n < m_size); return m_buffer[(m_pushed - m_size + n) & m_mask]; }
+
+        reference       front()       { return (*this)[0]; }
+        const_reference front() const { return (*this)[0]; }
+        reference       back()        { return (*this)[m_size - 1]; }
+        const_reference back()  const { return (*this)[m_size - 1]; }
+
+        // all values in chronological order as two contiguous blocks (the second may be empty)
+        std::pair<Span<T>, Span<T>> spans()
+        {
+            return make_spans<T>(m_buffer.data());
+        }
+
+        std::pair<Span<const T>, Span<const T>> spans() const
+        {
+            return make_spans<const T>(m_buffer.data());
+        }
+
+        // copies all values in chronological order to out, returns their number
+        size_type copy_to(T* out) const
+        {
+            const auto [older, newer] = spans();
+            out = std::copy(std::begin(older), std::end(older), out);
+            std::copy(std::begin(newer), std::end(newer), out);
+            return m_size;
+        }
+
+        // capacity
+        size_type size()     const { return m_size; }
+        size_type capacity() const { return m_mask + 1; }
+        bool      empty()    const { return m_size == 0; }
+        bool      full()     const { return m_size == capacity(); }
+
+        void clear()
+        {
+            m_size   = 0;
+            m_pushed = 0;
+        }
+
+        // iterators
+        iterator       begin()        { return { this, 0 }; }
+        iterator       end()          { return { this, m_size }; }
+        const_iterator begin()  const { return { this, 0 }; }
+        const_iterator end()    const { return { this, m_size }; }
+        const_iterator cbegin() const { return { this, 0 }; }
+        const_iterator cend()   const { return { this, m_size }; }
+
+    private:
+        std::vector<T, Allocator> m_buffer;
+        size_type                 m_mask   = 0;
+        size_type                 m_size   = 0;
+        size_type                 m_pushed = 0; // total number of pushes, masked for the position
+
+        template <class U>
+        std::pair<Span<U>, Span<U>> make_spans(U* data) const
+        {
+            const size_type first = (m_pushed - m_size) & m_mask;
+            const size_type split = std::min(m_size, capacity() - first);
+            return { Span<U>{ data + first, split }, Span<U>{ data, m_size - split } };
+        }
+    };
+}
+
+#endif // JUL_DYNAMIC_RING_H
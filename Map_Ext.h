@@ -25,7 +25,9 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <iterator>
 #include <map>
+#include <utility>
 #include <vector>
 
 namespace jul 
@@ -48,7 +50,8 @@ namespace jul
 
 
     // ---------------------------------------------------------------------------------
-    // Copy all keys from a map into a vector.
+    // Copy all keys from a map into a vector (see jul::keys in View.h for a view
+    // without a copy).
     // example:
     // std::map<int, std::string> m{ {1, "one"}, {2, "two"}, {3, "three"} };
     // auto keys = copy_keys(m);
@@ -59,7 +62,8 @@ namespace jul
     std::vector<Key> copy_keys(std::map<Key, Value> const& m)
     {
         std::vector<Key> keys;
-        for (auto kv : m) {
+        keys.reserve(std::size(m));
+        for (const auto& kv : m) {
             keys.push_back(kv.first);
         }
         return keys;
@@ -68,7 +72,7 @@ namespace jul
 
 
     // ---------------------------------------------------------------------------------
-    // Copy all values from a map into a vector.
+    // Copy all values from a map into a vector (see jul::values in View.h).
     // example:
     // std::map<int, std::string> m{ {1, "one"}, {2, "two"}, {3, "three"} };
     // auto values = copy_values(m);
@@ -79,7 +83,8 @@ namespace jul
     std::vector<Value> copy_values(std::map<Key, Value> const& m)
     {
         std::vector<Value> values;
-        for (auto kv : m) {
+        values.reserve(std::size(m));
+        for (const auto& kv : m) {
             values.push_back(kv.second);
         }
         return values;
@@ -100,11 +105,13 @@ namespace jul
     {
         std::vector<Key>   keys;
         std::vector<Value> values;
-        for (auto [key, value] : m) {
+        keys.reserve(std::size(m));
+        values.reserve(std::size(m));
+        for (const auto& [key, value] : m) {
             keys.push_back(key);
             values.push_back(value);
         }
-        return {keys, values};
+        return { std::move(keys), std::move(values) };
     }
     
     
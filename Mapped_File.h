@@ -0,0 +1,179 @@
+#ifndef JUL_MAPPED_FILE_H
+#define JUL_MAPPED_FILE_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <cassert>
+#include <cstddef>
+
+// The platform API stays out of File.h. No NOMINMAX or other macros are defined
+// here, the code below doesn't call min / max.
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace jul {
+
+    // -------------------------------------------------------------------------------------
+    // Mapped_File (class): a file mapped into memory (mmap / CreateFileMapping).
+    // Reads and writes are plain memory accesses without a syscall. Writes of a shared
+    // mapping reach the file even if the process crashes, flush() also protects them
+    // against a crash of the OS.
+    // Example:
+    // Mapped_File file;
+    // if (file.open("state.bin", Mapped_File::Access::Read_Write, 4096)) {
+    //     std::memcpy(file.data(), &state, sizeof(state));
+    // }
+    // -------------------------------------------------------------------------------------
+    class Mapped_File {
+    public:
+
+        using Bytes = std::size_t;
+
+        enum class Access {
+            Read,       // Map an existing file read only, fails on non existing file.
+            Read_Write  // Map a file for read and write, creates it if it doesn't exist.
+        };
+
+        Mapped_File()  {}
+        ~Mapped_File() { close(); }
+
+        // no copy & move
+        Mapped_File(Mapped_File&&)                 = delete;
+        Mapped_File(const Mapped_File&)            = delete;
+        Mapped_File& operator=(Mapped_File&&)      = delete;
+        Mapped_File& operator=(const Mapped_File&) = delete;
+
+        // Maps the whole file. With Read_Write the file grows to 'size' bytes first if
+        // it is smaller (size 0 keeps the current size). Empty files can't be mapped.
+        bool open(const char* file_name, Access access, Bytes size = 0)
+        {
+            assert(file_name);
+            close();
+
+            const bool writable = access == Access::Read_Write;
+#if defined(_WIN32)
+            m_file = CreateFileA(file_name, writable ? GENERIC_READ | GENERIC_WRITE : GENERIC_READ,
+                                 FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr, writable ? OPEN_ALWAYS : OPEN_EXISTING,
+                                 FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE) return false;
+
+            LARGE_INTEGER file_size;
+            if (!GetFileSizeEx(m_file, &file_size)) { close(); return false; }
+            m_size = static_cast<Bytes>(file_size.QuadPart);
+
+            if (writable && size > m_size) {
+                LARGE_INTEGER new_size;
+                new_size.QuadPart = static_cast<LONGLONG>(size);
+                if (!SetFilePointerEx(m_file, new_size, nullptr, FILE_BEGIN) || !SetEndOfFile(m_file)) { close(); return false; }
+                m_size = size;
+            }
+            if (m_size == 0) { close(); return false; }
+
+            m_mapping = CreateFileMappingA(m_file, nullptr, writable ? PAGE_READWRITE : PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping == nullptr) { close(); return false; }
+
+            m_data = MapViewOfFile(m_mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, 0);
+            if (m_data == nullptr) { close(); return false; }
+#else
+            m_file = ::open(file_name, writable ? O_RDWR | O_CREAT : O_RDONLY, 0644);
+            if (m_file < 0) return false;
+
+            struct stat file_stat;
+            if (::fstat(m_file, &file_stat) != 0) { close(); return false; }
+            m_size = static_cast<Bytes>(file_stat.st_size);
+
+            if (writable && size > m_size) {
+                if (::ftruncate(m_file, static_cast<off_t>(size)) != 0) { close(); return false; }
+                m_size = size;
+            }
+            if (m_size == 0) { close(); return false; }
+
+            void* data = ::mmap(nullptr, m_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, m_file, 0);
+            if (data == MAP_FAILED) { close(); return false; }
+            m_data = data;
+#endif
+            m_writable = writable;
+            return true;
+        }
+
+        // Writes the dirty pages to the disk. async: only start the write back.
+        bool flush(bool async = false)
+        {
+            assert(is_open());
+#if defined(_WIN32)
+            const bool flushed = FlushViewOfFile(m_data, 0) != 0;
+            return async ? flushed : flushed && FlushFileBuffers(m_file) != 0;
+#else
+            return ::msync(m_data, m_size, async ? MS_ASYNC : MS_SYNC) == 0;
+#endif
+        }
+
+        void close()
+        {
+#if defined(_WIN32)
+            if (m_data)                         UnmapViewOfFile(m_data);
+            if (m_mapping)                      CloseHandle(m_mapping);
+            if (m_file != INVALID_HANDLE_VALUE) CloseHandle(m_file);
+            m_mapping = nullptr;
+            m_file    = INVALID_HANDLE_VALUE;
+#else
+            if (m_data)      ::munmap(m_data, m_size);
+            if (m_file >= 0) ::close(m_file);
+            m_file = -1;
+#endif
+            m_data     = nullptr;
+            m_size     = 0;
+            m_writable = false;
+        }
+
+        bool        is_open()     const { return m_data != nullptr; }
+        bool        is_writable() const { return m_writable; }
+        Bytes       size()        const { return m_size; }
+        void*       data()              { assert(m_writable); return m_data; }
+        const void* data()        const { return m_data; }
+
+    private:
+
+        void* m_data     = nullptr;
+        Bytes m_size     = 0;
+        bool  m_writable = false;
+#if defined(_WIN32)
+        HANDLE m_file    = INVALID_HANDLE_VALUE;
+        HANDLE m_mapping = nullptr;
+#else
+        int    m_file    = -1;
+#endif
+    };
+
+}
+
+#endif // JUL_MAPPED_FILE_H
@@ -0,0 +1,205 @@
+#ifndef JUL_MAPPED_RING_H
+#define JUL_MAPPED_RING_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "Bit.h"
+#include "Mapped_File.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------
+    // File layout of a Mapped_Ring: this header (one cache line),
+    // followed by 'capacity' values.
+    // ---------------------------------------------------------------
+    struct alignas(64) Mapped_Ring_Header {
+        static constexpr std::uint64_t Magic   = 0x31474E49524C554AULL; // "JULRING1"
+        static constexpr std::uint32_t Version = 1;
+
+        std::uint64_t              magic;
+        std::uint32_t              version;
+        std::uint32_t              value_size; // sizeof(T)
+        std::uint64_t              capacity;   // power of two
+        std::uint64_t              generation; // +1 every time a writer opens the file
+        std::atomic<std::uint64_t> pushed;     // total number of pushes, masked for the position
+    };
+
+    static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Mapped_Ring needs lock free 64 bit atomics in shared memory!");
+
+
+
+    // ---------------------------------------------------------------
+    // Mapped_Ring (class) = overwriting ring of the last N values in a
+    // memory mapped file (a flight recorder).
+    // A push is one copy into the mapping plus a release store of the
+    // index: no syscall, no flush. The OS writes the pages back, so the
+    // values survive a crash of the process (flush() for OS crashes).
+    // Read the file with recover_ring after the crash.
+    //
+    // T has to be trivially copyable (it is stored as raw bytes).
+    // Reopening a file with the same type and capacity continues it
+    // and increments the generation, other files are reset.
+    //
+    // Example:
+    // Mapped_Ring<Event> recorder;
+    // recorder.open("events.ring", 4096);
+    // recorder.push(event);
+    // ...
+    // Recovered_Ring<Event> crash;
+    // if (recover_ring("events.ring", crash)) { dump(crash.values); }
+    // ---------------------------------------------------------------
+    template <class T>
+    class Mapped_Ring {
+    public:
+
+        static_assert(std::is_trivially_copyable<T>::value, "Mapped_Ring stores raw bytes, T has to be trivially copyable!");
+
+        using value_type = T;
+        using size_type  = std::size_t;
+
+        // Bytes of a file with room for 'capacity' values.
+        static constexpr size_type file_size(size_type capacity)
+        {
+            return values_offset() + capacity * sizeof(T);
+        }
+
+        // opens or creates the file with room for at least min_capacity values
+        bool open(const char* file_name, size_type min_capacity)
+        {
+            const size_type capacity = next_power_of_two(std::max<size_type>(min_capacity, 1));
+            if (!m_file.open(file_name, Mapped_File::Access::Read_Write, file_size(capacity))) return false;
+
+            m_header = static_cast<Mapped_Ring_Header*>(m_file.data());
+            m_values = reinterpret_cast<T*>(static_cast<unsigned char*>(m_file.data()) + values_offset());
+            m_mask   = capacity - 1;
+
+            const bool continues = m_header->magic == Mapped_Ring_Header::Magic
+                                && m_header->version == Mapped_Ring_Header::Version
+                                && m_header->value_size == sizeof(T)
+                                && m_header->capacity == capacity
+                                && m_file.size() >= file_size(capacity);
+            if (continues) {
+                ++m_header->generation;
+            }
+            else {
+                m_header->magic      = Mapped_Ring_Header::Magic;
+                m_header->version    = Mapped_Ring_Header::Version;
+                m_header->value_size = sizeof(T);
+                m_header->capacity   = capacity;
+                m_header->generation = 1;
+                m_header->pushed.store(0, std::memory_order_relaxed);
+            }
+            return true;
+        }
+
+        // Single writer: copies the value into the mapping, then publishes it.
+        void push(const T& value)
+        {
+            assert(is_open());
+            const std::uint64_t pushed = m_header->pushed.load(std::memory_order_relaxed);
+            std::memcpy(static_cast<void*>(m_values + (pushed & m_mask)), &value, sizeof(T));
+            m_header->pushed.store(pushed + 1, std::memory_order_release);
+        }
+
+        bool flush(bool async = false) { return m_file.flush(async); }
+        void close()                   { m_file.close(); m_header = nullptr; m_values = nullptr; }
+
+        bool          is_open()    const { return m_file.is_open(); }
+        size_type     capacity()   const { return m_mask + 1; }
+        std::uint64_t pushed()     const { assert(is_open()); return m_header->pushed.load(std::memory_order_relaxed); }
+        std::uint64_t generation() const { assert(is_open()); return m_header->generation; }
+        size_type     size()       const { return static_cast<size_type>(std::min<std::uint64_t>(pushed(), capacity())); }
+
+        static constexpr size_type values_offset()
+        {
+            return (sizeof(Mapped_Ring_Header) + alignof(T) - 1) / alignof(T) * alignof(T);
+        }
+
+    private:
+        Mapped_File         m_file;
+        Mapped_Ring_Header* m_header = nullptr;
+        T*                  m_values = nullptr;
+        size_type           m_mask   = 0;
+    };
+
+
+
+    // ---------------------------------------------------------------
+    // Content of a Mapped_Ring file, values from the oldest to the newest.
+    // ---------------------------------------------------------------
+    template <class T>
+    struct Recovered_Ring {
+        std::uint64_t  generation = 0;
+        std::uint64_t  pushed     = 0;
+        std::vector<T> values;
+    };
+
+
+
+    // ---------------------------------------------------------------
+    // Reads a Mapped_Ring file (e.g. after a crash of the writer), false if
+    // the file is missing or was written with another value type.
+    // The slot after the newest value is skipped: a crash during a push may
+    // have left it half written. So a full ring recovers capacity - 1 values.
+    // ---------------------------------------------------------------
+    template <class T>
+    bool recover_ring(const char* file_name, Recovered_Ring<T>& out)
+    {
+        Mapped_File mapping;
+        if (!mapping.open(file_name, Mapped_File::Access::Read)) return false;
+
+        const Mapped_File& file = mapping;
+        if (file.size() < sizeof(Mapped_Ring_Header)) return false;
+
+        const auto* header = static_cast<const Mapped_Ring_Header*>(file.data());
+        if (header->magic != Mapped_Ring_Header::Magic || header->version != Mapped_Ring_Header::Version) return false;
+        if (header->value_size != sizeof(T) || !is_power_of_two(header->capacity)) return false;
+        if (file.size() < Mapped_Ring<T>::file_size(header->capacity)) return false;
+
+        const auto*         values   = reinterpret_cast<const T*>(static_cast<const unsigned char*>(file.data()) + Mapped_Ring<T>::values_offset());
+        const std::uint64_t capacity = header->capacity;
+        const std::uint64_t pushed   = header->pushed.load(std::memory_order_acquire);
+        const std::uint64_t count    = pushed < capacity ? pushed : capacity - 1;
+
+        out.generation = header->generation;
+        out.pushed     = pushed;
+        out.values.resize(static_cast<std::size_t>(count));
+        for (std::uint64_t n = 0; n < count; ++n) {
+            std::memcpy(static_cast<void*>(&out.values[n]), values + ((pushed - count + n) & (capacity - 1)), sizeof(T));
+        }
+        return true;
+    }
+}
+
+#endif // JUL_MAPPED_RING_H
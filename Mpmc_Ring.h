@@ -0,0 +1,284 @@
+#ifndef JUL_MPMC_RING_H
+#define JUL_MPMC_RING_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+#include "Parallel.h"
+#include "Ring.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------
+    // Mpmc_Ring (class) = bounded multi producer, multi consumer queue
+    // (Dmitry Vyukov's sequence numbered ring) on jul::Ring storage.
+    //
+    // Every cell has a sequence number that says whose turn it is:
+    // sequence == pos            -> free for the producer of pos
+    // sequence == pos + 1        -> filled, ready for the consumer of pos
+    // sequence == pos + Size     -> free again for the next lap
+    // Producers and consumers only contend on one counter each (one
+    // CAS per operation), there is no lock that could convoy.
+    //
+    // try_*   never block.
+    // push/pop block: they spin with exponential backoff, then sleep in
+    //         std::atomic::wait (futex) if the library supports it
+    //         (C++20), otherwise they keep yielding.
+    //
+    // Example:
+    // Mpmc_Ring<Job, 1024> jobs;
+    // jobs.push(job);                        // any producer thread
+    // Job job; jobs.pop(job);                // any consumer thread
+    // Job batch[32]; auto count = jobs.try_pop_n(batch, 32);
+    // ---------------------------------------------------------------
+    template <class T, std::size_t Size>
+    class Mpmc_Ring {
+    public:
+
+        static_assert(Size > 1 && (Size & (Size - 1)) == 0, "The size of a Mpmc_Ring has to be a power of two (> 1)!");
+
+        // member types
+        using value_type = T;
+        using size_type  = std::size_t;
+
+        Mpmc_Ring()
+        {
+            for (size_type n = 0; n < Size; ++n) {
+                m_cells[n].sequence.store(n, std::memory_order_relaxed);
+            }
+        }
+
+        Mpmc_Ring(const Mpmc_Ring&)            = delete;
+        Mpmc_Ring& operator=(const Mpmc_Ring&) = delete;
+
+        // false if the ring is full
+        bool try_push(const T& value) { return try_emplace(value); }
+        bool try_push(T&& value)      { return try_emplace(std::move(value)); }
+
+        template <class... Args>
+        bool try_emplace(Args&&... args)
+        {
+            Claim claim = claim_push();
+            if (!claim.cell) return false;
+
+            claim.cell->value = T(std::forward<Args>(args)...);
+            publish(*claim.cell, claim.pos + 1);
+            return true;
+        }
+
+        // blocks while the ring is full
+        void push(const T& value) { emplace(value); }
+        void push(T&& value)      { emplace(std::move(value)); }
+
+        template <class... Args>
+        void emplace(Args&&... args)
+        {
+            Backoff backoff;
+            for (;;) {
+                Claim claim = claim_push();
+                if (claim.cell) {
+                    claim.cell->value = T(std::forward<Args>(args)...);
+                    publish(*claim.cell, claim.pos + 1);
+                    return;
+                }
+                wait(backoff, claim);
+            }
+        }
+
+        // false if the ring is empty
+        bool try_pop(T& out)
+        {
+            Claim claim = claim_pop();
+            if (!claim.cell) return false;
+
+            out = std::move(claim.cell->value);
+            publish(*claim.cell, claim.pos + Size);
+            return true;
+        }
+
+        // blocks while the ring is empty
+        void pop(T& out)
+        {
+            Backoff backoff;
+            for (;;) {
+                Claim claim = claim_pop();
+                if (claim.cell) {
+                    out = std::move(claim.cell->value);
+                    publish(*claim.cell, claim.pos + Size);
+                    return;
+                }
+                wait(backoff, claim);
+            }
+        }
+
+        // Pops up to count values with a single CAS, returns how many were popped.
+        size_type try_pop_n(T* out, size_type count)
+        {
+            for (;;) {
+                size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+                // count the consecutive filled cells
+                size_type ready = 0;
+                while (ready < count && m_cells[(pos + ready) & Mask].sequence.load(std::memory_order_acquire) == pos + ready + 1) {
+                    ++ready;
+                }
+
+                if (ready == 0) {
+                    const auto diff = distance(m_cells[pos & Mask].sequence.load(std::memory_order_acquire), pos + 1);
+                    if (diff < 0) return 0; // empty
+                    continue;               // pos is outdated
+                }
+
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + ready, std::memory_order_relaxed)) {
+                    for (size_type n = 0; n < ready; ++n) {
+                        Cell& cell = m_cells[(pos + n) & Mask];
+                        out[n] = std::move(cell.value);
+                        publish(cell, pos + n + Size);
+                    }
+                    return ready;
+                }
+            }
+        }
+
+        // Only a snapshot while other threads are running!
+        size_type size_approx() const
+        {
+            const size_type enqueued = m_enqueue_pos.load(std::memory_order_acquire);
+            const size_type dequeued = m_dequeue_pos.load(std::memory_order_acquire);
+            return enqueued > dequeued ? enqueued - dequeued : 0;
+        }
+
+        bool empty_approx() const { return size_approx() == 0; }
+
+        static constexpr size_type capacity() { return Size; }
+
+    private:
+        static constexpr size_type Mask = Size - 1;
+
+        struct Cell {
+            std::atomic<size_type> sequence{ 0 };
+            T                      value = {};
+        };
+
+        // a claimed cell, or (cell == nullptr) the cell that blocked and its sequence
+        struct Claim {
+            Cell*     cell     = nullptr;
+            size_type pos      = 0;
+            Cell*     blocking = nullptr;
+            size_type seen     = 0;
+        };
+
+        alignas(cache_line_size) std::atomic<size_type> m_enqueue_pos{ 0 };
+        alignas(cache_line_size) std::atomic<size_type> m_dequeue_pos{ 0 };
+        alignas(cache_line_size) std::atomic<int>       m_waiters{ 0 };
+        alignas(cache_line_size) Ring<Cell, Size>       m_cells;
+
+        static std::intptr_t distance(size_type sequence, size_type pos)
+        {
+            return static_cast<std::intptr_t>(sequence - pos);
+        }
+
+        Claim claim_push()
+        {
+            size_type pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell&           cell     = m_cells[pos & Mask];
+                const size_type sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto      diff     = distance(sequence, pos);
+
+                if (diff == 0) {
+                    if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return { &cell, pos };
+                    }
+                }
+                else if (diff < 0) {
+                    return { nullptr, pos, &cell, sequence }; // full
+                }
+                else {
+                    pos = m_enqueue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        Claim claim_pop()
+        {
+            size_type pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            for (;;) {
+                Cell&           cell     = m_cells[pos & Mask];
+                const size_type sequence = cell.sequence.load(std::memory_order_acquire);
+                const auto      diff     = distance(sequence, pos + 1);
+
+                if (diff == 0) {
+                    if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                        return { &cell, pos };
+                    }
+                }
+                else if (diff < 0) {
+                    return { nullptr, pos, &cell, sequence }; // empty
+                }
+                else {
+                    pos = m_dequeue_pos.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Hands the cell to the next owner. The store and the waiter check are both
+        // seq_cst, so a thread that goes to sleep either sees the new sequence or is
+        // seen as waiter and woken.
+        void publish(Cell& cell, size_type sequence)
+        {
+            cell.sequence.store(sequence, std::memory_order_seq_cst);
+#if defined(__cpp_lib_atomic_wait)
+            if (m_waiters.load(std::memory_order_seq_cst) != 0) {
+                cell.sequence.notify_all();
+            }
+#endif
+        }
+
+        // spins first, sleeps until the blocking cell changes afterwards
+        void wait(Backoff& backoff, const Claim& claim)
+        {
+            if (backoff.is_spinning()) {
+                backoff.pause();
+                return;
+            }
+#if defined(__cpp_lib_atomic_wait)
+            m_waiters.fetch_add(1, std::memory_order_seq_cst);
+            claim.blocking->sequence.wait(claim.seen, std::memory_order_seq_cst);
+            m_waiters.fetch_sub(1, std::memory_order_relaxed);
+#else
+            (void)claim;
+            backoff.pause();
+#endif
+        }
+    };
+}
+
+#endif // JUL_MPMC_RING_H
@@ -0,0 +1,267 @@
+#ifndef JUL_PARALLEL_H
+#define JUL_PARALLEL_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <execution>
+#include <numeric>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace jul {
+
+    // -------------------------------------------------------------------------------------
+    // Shared helpers for the parallel algorithms of this library.
+    //
+    // Scheduler:
+    // Every algorithm with an '_on' suffix (e.g. sort_on) runs its parallel work on a user
+    // supplied scheduler instead of the std::execution::par thread pool. A scheduler is any
+    // type with the member function
+    //
+    // template <class Function>
+    // void parallel_for(std::size_t first, std::size_t last, std::size_t grain, Function&& fn);
+    //
+    // that calls fn(chunk_first, chunk_last) for disjoint chunks (of about 'grain' indices)
+    // covering [first, last) and returns after all chunks are done.
+    // jul::Thread_Pool (Thread_Pool.h) is such a scheduler, default_pool() is the pool
+    // shared by the whole program.
+    // -------------------------------------------------------------------------------------
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Inputs smaller than this are processed sequentially by default,
+    // spinning up the parallel backend would cost more than it saves.
+    // ---------------------------------------------------------------------------------
+    inline constexpr std::size_t parallel_threshold = 1 << 14;
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Number of hardware threads, at least 1. Cached, because querying it is a syscall.
+    // ---------------------------------------------------------------------------------
+    inline unsigned hardware_threads()
+    {
+        static const unsigned threads = std::max(1U, std::thread::hardware_concurrency());
+        return threads;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Size of a cache line. Data written by different threads is kept this far apart
+    // (alignas(cache_line_size)) to avoid false sharing.
+    // std::hardware_destructive_interference_size is not stable across compilers.
+    // ---------------------------------------------------------------------------------
+    inline constexpr std::size_t cache_line_size = 64;
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Hint for the CPU inside of spin loops (pause / yield): saves power and frees
+    // resources for the other hyper thread of the core.
+    // ---------------------------------------------------------------------------------
+    inline void cpu_relax()
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        _mm_pause();
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+        __yield();
+#elif defined(__x86_64__) || defined(__i386__)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        asm volatile("yield");
+#endif
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Exponential backoff for spin loops: pause() spins 1, 2, 4, ... cpu_relax() up to
+    // Spin_Limit, after that it yields the time slice. Blocking algorithms can check
+    // is_spinning() and switch to a real wait instead.
+    // Example:
+    // Backoff backoff;
+    // while (!flag.load(std::memory_order_acquire)) { backoff.pause(); }
+    // ---------------------------------------------------------------------------------
+    class Backoff {
+    public:
+        static constexpr unsigned Spin_Limit = 64;
+
+        void pause()
+        {
+            if (m_spins <= Spin_Limit) {
+                for (unsigned n = 0; n < m_spins; ++n) {
+                    cpu_relax();
+                }
+                m_spins *= 2;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+
+        bool is_spinning() const { return m_spins <= Spin_Limit; }
+        void reset()             { m_spins = 1; }
+
+    private:
+        unsigned m_spins = 1;
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Small number of the current thread: 0, 1, 2, ... in the order the threads first
+    // call it, it never changes for a thread. Index for per thread slots
+    // (slots[thread_index() % Slots]).
+    // std::this_thread::get_id() can not be used as index and the CPU of a thread
+    // can change at any time.
+    // ---------------------------------------------------------------------------------
+    inline std::size_t thread_index()
+    {
+        static std::atomic<std::size_t> next_index{ 0 };
+        thread_local const std::size_t index = next_index.fetch_add(1, std::memory_order_relaxed);
+        return index;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Is T one of the std::execution policies?
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    inline constexpr bool is_execution_policy_v = std::is_execution_policy<std::decay_t<T>>::value;
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Calls fn(policy) with std::execution::seq for small inputs and std::execution::par
+    // for large inputs.
+    // Example:
+    // with_policy(std::size(v), [&](auto policy) { std::sort(policy, std::begin(v), std::end(v)); });
+    // ---------------------------------------------------------------------------------
+    template <class Function>
+    decltype(auto) with_policy(std::size_t size, Function&& fn, std::size_t threshold = parallel_threshold)
+    {
+        if (size < threshold) {
+            return fn(std::execution::seq);
+        }
+        return fn(std::execution::par);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Chunks of the chunked algorithms (e.g. apply_each_on) hold about this many bytes,
+    // so a chunk stays in the cache of the core that works on it.
+    // ---------------------------------------------------------------------------------
+    inline constexpr std::size_t chunk_bytes = 1 << 16;
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Default grain for 'size' elements of type T: cache sized chunks, but at least
+    // 4 chunks per thread for load balancing. Inputs below parallel_threshold are
+    // one chunk, they run sequentially.
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    std::size_t default_grain(std::size_t size)
+    {
+        if (size < parallel_threshold) {
+            return std::max<std::size_t>(size, 1);
+        }
+
+        const std::size_t cache_grain   = std::max<std::size_t>(chunk_bytes / sizeof(T), 1);
+        const std::size_t min_chunks    = 4 * std::size_t{ hardware_threads() };
+        const std::size_t balance_grain = (size + min_chunks - 1) / min_chunks;
+        return std::min(cache_grain, balance_grain);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Calls fn(chunk_first, chunk_last) for chunks of 'grain' indices of [0, size) on
+    // the scheduler. A grain of 0 selects default_grain<T>. When everything fits into
+    // one chunk, fn is called directly without the scheduler (sequential fallback).
+    // Example:
+    // chunked_for<float>(scheduler, std::size(v), 0, [&](std::size_t first, std::size_t last) { ... });
+    // ---------------------------------------------------------------------------------
+    template <class T, class Scheduler, class Function>
+    void chunked_for(Scheduler& scheduler, std::size_t size, std::size_t grain, Function&& fn)
+    {
+        if (size == 0) return;
+
+        if (grain == 0) {
+            grain = default_grain<T>(size);
+        }
+
+        if (grain >= size) {
+            fn(std::size_t{ 0 }, size);
+            return;
+        }
+        scheduler.parallel_for(0, size, grain, fn);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Scheduler that runs the chunks on the std::execution::par backend.
+    // ---------------------------------------------------------------------------------
+    struct Default_Scheduler {
+
+        template <class Function>
+        void parallel_for(std::size_t first, std::size_t last, std::size_t grain, Function&& fn)
+        {
+            if (first >= last) return;
+
+            grain = std::max<std::size_t>(grain, 1);
+            const std::size_t chunks = (last - first + grain - 1) / grain;
+            if (chunks == 1) {
+                fn(first, last);
+                return;
+            }
+
+            std::vector<std::size_t> chunk_index(chunks);
+            std::iota(std::begin(chunk_index), std::end(chunk_index), std::size_t{ 0 });
+            std::for_each(std::execution::par, std::begin(chunk_index), std::end(chunk_index), [&](std::size_t n) {
+                const std::size_t chunk_first = first + n * grain;
+                fn(chunk_first, std::min(chunk_first + grain, last));
+            });
+        }
+    };
+}
+
+#endif // JUL_PARALLEL_H
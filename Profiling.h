@@ -25,7 +25,16 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+#include "Parallel.h"
 
 // helper macros to create a scope timer
 #if defined(_DEBUG) || defined(DEBUG)
@@ -35,8 +44,23 @@ SOFTWARE.
 #endif
 
 namespace jul {
+
+    class Lock_Stats;
+
 namespace detail {
 
+    // all living Lock_Stats (for lock_reports)
+    struct Lock_Stats_Registry {
+        std::mutex                     mutex;
+        std::vector<const Lock_Stats*> stats;
+    };
+
+    inline Lock_Stats_Registry& lock_stats_registry()
+    {
+        static Lock_Stats_Registry registry;
+        return registry;
+    }
+
     template <class Out = std::ostream>
     struct Scope_Timer {
         using Clock = std::chrono::steady_clock;
@@ -67,6 +91,265 @@ namespace detail {
     };
 
  }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Time stamp counter of the CPU (rdtsc) for cheap measurements of short waits.
+    // Other CPUs fall back to steady_clock nanoseconds.
+    // ---------------------------------------------------------------------------------
+    inline std::uint64_t read_cycles()
+    {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+        return __rdtsc();
+#elif defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Counters of one lock (a snapshot).
+    // contended: lock() calls that did not get the lock at once and had to wait.
+    // spin_cycles / max_wait_cycles: cycles of read_cycles() spent waiting.
+    // ---------------------------------------------------------------------------------
+    struct Lock_Report {
+        const char*   name            = "";
+        std::uint64_t acquisitions    = 0;
+        std::uint64_t contended       = 0;
+        std::uint64_t spin_cycles     = 0;
+        std::uint64_t max_wait_cycles = 0;
+
+        double contention() const { return acquisitions ? static_cast<double>(contended) / static_cast<double>(acquisitions) : 0.0; }
+    };
+
+    inline std::ostream& operator<<(std::ostream& out, const Lock_Report& report)
+    {
+        return out << report.name
+                   << ": acquisitions " << report.acquisitions
+                   << ", contended " << report.contended << " (" << report.contention() * 100.0 << " %)"
+                   << ", spin cycles " << report.spin_cycles
+                   << ", max wait " << report.max_wait_cycles << " cycles";
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Counters of an Instrumented_Lock. Every thread adds to its own cache line sized
+    // slot, so counting does not add contention to the lock it measures.
+    // All living Lock_Stats are listed by lock_reports().
+    // ---------------------------------------------------------------------------------
+    class Lock_Stats {
+    public:
+        static constexpr std::size_t Slots = 64;
+
+        explicit Lock_Stats(const char* name) : m_name{ name }
+        {
+            auto& registry = detail::lock_stats_registry();
+            std::lock_guard<std::mutex> guard(registry.mutex);
+            registry.stats.push_back(this);
+        }
+
+        ~Lock_Stats()
+        {
+            auto& registry = detail::lock_stats_registry();
+            std::lock_guard<std::mutex> guard(registry.mutex);
+            registry.stats.erase(std::find(std::begin(registry.stats), std::end(registry.stats), this));
+        }
+
+        Lock_Stats(const Lock_Stats&)            = delete;
+        Lock_Stats& operator=(const Lock_Stats&) = delete;
+
+        void record(bool contended, std::uint64_t wait_cycles)
+        {
+            Slot& slot = m_slots[thread_index() % Slots];
+            slot.acquisitions.fetch_add(1, std::memory_order_relaxed);
+            if (!contended) return;
+
+            slot.contended.fetch_add(1, std::memory_order_relaxed);
+            slot.spin_cycles.fetch_add(wait_cycles, std::memory_order_relaxed);
+            std::uint64_t max_wait = slot.max_wait_cycles.load(std::memory_order_relaxed);
+            while (wait_cycles > max_wait && !slot.max_wait_cycles.compare_exchange_weak(max_wait, wait_cycles, std::memory_order_relaxed)) {}
+        }
+
+        Lock_Report report() const
+        {
+            Lock_Report report;
+            report.name = m_name;
+            for (const Slot& slot : m_slots) {
+                report.acquisitions   += slot.acquisitions.load(std::memory_order_relaxed);
+                report.contended      += slot.contended.load(std::memory_order_relaxed);
+                report.spin_cycles    += slot.spin_cycles.load(std::memory_order_relaxed);
+                report.max_wait_cycles = std::max(report.max_wait_cycles, slot.max_wait_cycles.load(std::memory_order_relaxed));
+            }
+            return report;
+        }
+
+        void reset()
+        {
+            for (Slot& slot : m_slots) {
+                slot.acquisitions.store(0, std::memory_order_relaxed);
+                slot.contended.store(0, std::memory_order_relaxed);
+                slot.spin_cycles.store(0, std::memory_order_relaxed);
+                slot.max_wait_cycles.store(0, std::memory_order_relaxed);
+            }
+        }
+
+    private:
+        struct alignas(cache_line_size) Slot {
+            std::atomic<std::uint64_t> acquisitions{ 0 };
+            std::atomic<std::uint64_t> contended{ 0 };
+            std::atomic<std::uint64_t> spin_cycles{ 0 };
+            std::atomic<std::uint64_t> max_wait_cycles{ 0 };
+        };
+
+        const char* m_name;
+        Slot        m_slots[Slots];
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Reports of all living instrumented locks, the most spin cycles first.
+    // Example:
+    // print_lock_reports();   // at shutdown or from a debug command
+    // ---------------------------------------------------------------------------------
+    inline std::vector<Lock_Report> lock_reports()
+    {
+        auto& registry = detail::lock_stats_registry();
+        std::vector<Lock_Report> reports;
+        {
+            std::lock_guard<std::mutex> guard(registry.mutex);
+            reports.reserve(std::size(registry.stats));
+            for (const Lock_Stats* stats : registry.stats) {
+                reports.push_back(stats->report());
+            }
+        }
+        std::sort(std::begin(reports), std::end(reports), [](const Lock_Report& a, const Lock_Report& b) { return a.spin_cycles > b.spin_cycles; });
+        return reports;
+    }
+
+    inline void print_lock_reports(std::ostream& out = std::cout)
+    {
+        for (const Lock_Report& report : lock_reports()) {
+            out << report << '\n';
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Instrumented_Lock (class) = any lock (Spin_Lock, Ticket_Lock, Mcs_Lock,
+    // Shared_Spin_Lock, std::mutex, ...) that counts its acquisitions and measures
+    // how long lock() waits. A lock() first tries try_lock(): only the calls that
+    // fail are contended and timed, an uncontended lock() costs one counter increment.
+    // Shared locking is counted too (if Lock has it).
+    //
+    // Profiled_Lock<Lock> is an Instrumented_Lock<Lock> if JUL_LOCK_STATS is defined,
+    // otherwise a plain Lock that ignores the name: the instrumentation is opt-in per
+    // build without changes to the code.
+    //
+    // Example:
+    // Profiled_Lock<Spin_Lock> m_routes_lock{ "routes" };
+    // std::lock_guard<Profiled_Lock<Spin_Lock>> guard(m_routes_lock);
+    // ...
+    // print_lock_reports(); // g++ -DJUL_LOCK_STATS ...
+    // ---------------------------------------------------------------------------------
+    template <class Lock>
+    class Instrumented_Lock {
+    public:
+        using lock_type = Lock;
+
+        explicit Instrumented_Lock(const char* name = "lock") : m_stats{ name } {}
+
+        Instrumented_Lock(const Instrumented_Lock&)            = delete;
+        Instrumented_Lock& operator=(const Instrumented_Lock&) = delete;
+
+        void lock()
+        {
+            if (m_lock.try_lock()) {
+                m_stats.record(false, 0);
+                return;
+            }
+            const std::uint64_t start = read_cycles();
+            m_lock.lock();
+            m_stats.record(true, read_cycles() - start);
+        }
+
+        bool try_lock()
+        {
+            const bool locked = m_lock.try_lock();
+            if (locked) m_stats.record(false, 0);
+            return locked;
+        }
+
+        void unlock() { m_lock.unlock(); }
+
+        void lock_shared()
+        {
+            if (m_lock.try_lock_shared()) {
+                m_stats.record(false, 0);
+                return;
+            }
+            const std::uint64_t start = read_cycles();
+            m_lock.lock_shared();
+            m_stats.record(true, read_cycles() - start);
+        }
+
+        bool try_lock_shared()
+        {
+            const bool locked = m_lock.try_lock_shared();
+            if (locked) m_stats.record(false, 0);
+            return locked;
+        }
+
+        void unlock_shared() { m_lock.unlock_shared(); }
+
+        Lock_Report report() const { return m_stats.report(); }
+        void        reset()        { m_stats.reset(); }
+
+    private:
+        Lock       m_lock;
+        Lock_Stats m_stats;
+    };
+
+
+
+    namespace detail {
+
+        // Profiled_Lock without JUL_LOCK_STATS: only forwards (inlined away)
+        template <class Lock>
+        class Named_Lock {
+        public:
+            using lock_type = Lock;
+
+            explicit Named_Lock(const char* = "lock") {}
+
+            Named_Lock(const Named_Lock&)            = delete;
+            Named_Lock& operator=(const Named_Lock&) = delete;
+
+            void lock()            { m_lock.lock(); }
+            bool try_lock()        { return m_lock.try_lock(); }
+            void unlock()          { m_lock.unlock(); }
+            void lock_shared()     { m_lock.lock_shared(); }
+            bool try_lock_shared() { return m_lock.try_lock_shared(); }
+            void unlock_shared()   { m_lock.unlock_shared(); }
+
+        private:
+            Lock m_lock;
+        };
+    }
+
+#if defined(JUL_LOCK_STATS)
+    template <class Lock>
+    using Profiled_Lock = Instrumented_Lock<Lock>;
+#else
+    template <class Lock>
+    using Profiled_Lock = detail::Named_Lock<Lock>;
+#endif
 }
 
 #endif // JUL_PROFILING_H
\ No newline at end of file
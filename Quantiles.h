@@ -0,0 +1,398 @@
+#ifndef JUL_QUANTILES_H
+#define JUL_QUANTILES_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#include "Sort.h"
+
+// -------------------------------------------------------------------
+// Percentiles over large data sets and streams, the companions of
+// jul::mean / jul::stats (Vector_Ext.h):
+//
+// percentile       - exact, O(n) selection on a copy of the data.
+// Quantile_Sketch  - KLL sketch, any comparable type, mergeable,
+//                    one instance per thread.
+// Histogram        - log-bucketed (HDR-like) histogram of unsigned
+//                    integers, lock-free recording from many threads.
+// -------------------------------------------------------------------
+namespace jul {
+
+    namespace detail {
+
+        // index of the highest set bit, value can't be 0!
+        inline std::size_t highest_bit(std::uint64_t value)
+        {
+            assert(value != 0);
+#if defined(_MSC_VER)
+            unsigned long index = 0;
+            _BitScanReverse64(&index, value);
+            return index;
+#else
+            return 63 - static_cast<std::size_t>(__builtin_clzll(value));
+#endif
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Exact percentile (0 - 100) of some values, without sorting them (see jul::nth).
+    // Precondition: vector can't be empty!
+    // Example:
+    // auto p99 = percentile(latencies, 99.0);
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    T percentile(const std::vector<T>& values, double p)
+    {
+        assert(!values.empty() && "Calculation of a percentile is not possible on empty range!");
+        assert(p >= 0.0 && p <= 100.0);
+
+        const auto index = static_cast<std::size_t>(std::ceil(p / 100.0 * std::size(values)));
+        return jul::nth(values, index == 0 ? 0 : index - 1);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Quantile_Sketch (class): KLL quantile sketch (Karnin, Lang, Liberty 2016).
+    // Keeps O(K) values of a stream, the rank error is about 1.7 / K (K = 200 -> ~1%).
+    // Not thread safe, use one sketch per thread and merge them.
+    // For tail percentiles (p99.9) of integers prefer Histogram, its error is relative
+    // to the value and not to the rank.
+    // Example:
+    // Quantile_Sketch<double> sketch;
+    // for (auto sample : stream) { sketch.push(sample); }
+    // auto p99 = sketch.quantile(0.99);
+    // ---------------------------------------------------------------------------------
+    template <class T, std::size_t K = 200>
+    class Quantile_Sketch {
+    public:
+
+        static_assert(K >= 8, "A Quantile_Sketch needs a K of at least 8!");
+
+        Quantile_Sketch() { grow(); }
+
+        void push(const T& value)
+        {
+            m_compactors[0].push_back(value);
+            m_size++;
+            m_count++;
+            if (m_size >= m_max_size) {
+                compress();
+            }
+        }
+
+        void merge(const Quantile_Sketch& other)
+        {
+            if (&other == this) {
+                // insert() must not get iterators into the vector it inserts into
+                const Quantile_Sketch copy = other;
+                merge(copy);
+                return;
+            }
+            while (std::size(m_compactors) < std::size(other.m_compactors)) {
+                grow();
+            }
+            for (std::size_t h = 0; h < std::size(other.m_compactors); ++h) {
+                auto& level = m_compactors[h];
+                level.insert(std::end(level), std::begin(other.m_compactors[h]), std::end(other.m_compactors[h]));
+            }
+
+            m_count += other.m_count;
+            update_size();
+            while (m_size >= m_max_size) {
+                compress();
+            }
+        }
+
+        // Value at quantile q (0 - 1).
+        // Precondition: at least one value was pushed!
+        T quantile(double q) const
+        {
+            assert(m_count != 0 && "Quantile of an empty sketch!");
+            assert(q >= 0.0 && q <= 1.0);
+
+            const auto items = weighted_items();
+            std::uint64_t total = 0;
+            for (const auto& item : items) {
+                total += item.second;
+            }
+
+            const auto target = static_cast<std::uint64_t>(std::ceil(q * static_cast<double>(total)));
+            std::uint64_t seen = 0;
+            for (const auto& item : items) {
+                seen += item.second;
+                if (seen >= target) {
+                    return item.first;
+                }
+            }
+            return items.back().first;
+        }
+
+        // Approximate fraction of the values <= value.
+        double rank(const T& value) const
+        {
+            std::uint64_t below = 0;
+            std::uint64_t total = 0;
+            for (std::size_t h = 0; h < std::size(m_compactors); ++h) {
+                const std::uint64_t weight = std::uint64_t{ 1 } << h;
+                for (const auto& item : m_compactors[h]) {
+                    total += weight;
+                    below += item <= value ? weight : 0;
+                }
+            }
+            return total == 0 ? 0.0 : static_cast<double>(below) / static_cast<double>(total);
+        }
+
+        std::size_t count() const { return m_count; } // number of pushed values
+        std::size_t size()  const { return m_size;  } // number of stored values
+        bool        empty() const { return m_count == 0; }
+
+    private:
+
+        std::vector<std::vector<T>> m_compactors;
+        std::size_t   m_size     = 0;
+        std::size_t   m_max_size = 0;
+        std::size_t   m_count    = 0;
+        std::uint64_t m_random   = 0x9E3779B97F4A7C15ULL;
+
+        // capacity of a level shrinks by 2/3 for every level below the top
+        std::size_t capacity(std::size_t level) const
+        {
+            const auto depth = std::size(m_compactors) - level - 1;
+            return static_cast<std::size_t>(std::ceil(std::pow(2.0 / 3.0, depth) * K)) + 1;
+        }
+
+        void grow()
+        {
+            m_compactors.emplace_back();
+            m_max_size = 0;
+            for (std::size_t h = 0; h < std::size(m_compactors); ++h) {
+                m_max_size += capacity(h);
+            }
+        }
+
+        void update_size()
+        {
+            m_size = 0;
+            for (const auto& level : m_compactors) {
+                m_size += std::size(level);
+            }
+        }
+
+        bool random_bit()
+        {
+            // xorshift64
+            m_random ^= m_random << 13;
+            m_random ^= m_random >> 7;
+            m_random ^= m_random << 17;
+            return (m_random & 1) != 0;
+        }
+
+        // Sort the first full level and promote every second value (with weight * 2)
+        void compress()
+        {
+            for (std::size_t h = 0; h < std::size(m_compactors); ++h) {
+                if (std::size(m_compactors[h]) < capacity(h)) continue;
+                if (h + 1 >= std::size(m_compactors)) grow();
+
+                auto& level = m_compactors[h];
+                auto& next  = m_compactors[h + 1];
+                std::sort(std::begin(level), std::end(level));
+
+                const std::size_t pairs = std::size(level) / 2;
+                const std::size_t offset = random_bit() ? 1 : 0;
+                for (std::size_t n = 0; n < pairs; ++n) {
+                    next.push_back(level[2 * n + offset]);
+                }
+
+                // an odd value stays on its level
+                const bool odd = std::size(level) % 2 == 1;
+                if (odd) {
+                    level.front() = level.back();
+                }
+                level.resize(odd ? 1 : 0);
+
+                update_size();
+                if (m_size < m_max_size) break;
+            }
+        }
+
+        std::vector<std::pair<T, std::uint64_t>> weighted_items() const
+        {
+            std::vector<std::pair<T, std::uint64_t>> items;
+            items.reserve(m_size);
+            for (std::size_t h = 0; h < std::size(m_compactors); ++h) {
+                for (const auto& item : m_compactors[h]) {
+                    items.emplace_back(item, std::uint64_t{ 1 } << h);
+                }
+            }
+            std::sort(std::begin(items), std::end(items), [](const auto& a, const auto& b) { return a.first < b.first; });
+            return items;
+        }
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Histogram (class): log-bucketed histogram of unsigned integers (e.g. latencies in ns).
+    // Values below 2^Precision_Bits are exact, larger values land in buckets with a
+    // relative width of 2^-(Precision_Bits - 1) (Precision_Bits = 8 -> < 0.8% error).
+    // record() is a single relaxed atomic increment, so all threads can share one
+    // histogram without a lock. Fixed memory: ~60KB for Precision_Bits = 8.
+    // Example:
+    // Histogram<> latency;
+    // latency.record(duration_in_ns); // from any thread
+    // auto p99 = latency.percentile(99.0);
+    // ---------------------------------------------------------------------------------
+    template <std::size_t Precision_Bits = 8>
+    class Histogram {
+    public:
+
+        static_assert(Precision_Bits >= 2 && Precision_Bits <= 16, "Invalid precision!");
+
+        using value_type = std::uint64_t;
+
+        static constexpr std::size_t Half_Bucket  = std::size_t{ 1 } << (Precision_Bits - 1);
+        static constexpr std::size_t Bucket_Count  = (64 - Precision_Bits + 2) * Half_Bucket;
+
+        Histogram() = default;
+
+        // no copies, the counters are atomics
+        Histogram(const Histogram&)            = delete;
+        Histogram& operator=(const Histogram&) = delete;
+
+        void record(value_type value, value_type count = 1)
+        {
+            m_buckets[bucket_index(value)].fetch_add(count, std::memory_order_relaxed);
+            m_count.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        // Add all counts of another histogram (e.g. of another process / time window).
+        void merge(const Histogram& other)
+        {
+            for (std::size_t n = 0; n < Bucket_Count; ++n) {
+                const auto count = other.m_buckets[n].load(std::memory_order_relaxed);
+                if (count != 0) {
+                    m_buckets[n].fetch_add(count, std::memory_order_relaxed);
+                }
+            }
+            m_count.fetch_add(other.count(), std::memory_order_relaxed);
+        }
+
+        void reset()
+        {
+            for (auto& bucket : m_buckets) {
+                bucket.store(0, std::memory_order_relaxed);
+            }
+            m_count.store(0, std::memory_order_relaxed);
+        }
+
+        value_type count() const { return m_count.load(std::memory_order_relaxed); }
+
+        // Approximate value at percentile p (0 - 100), returns 0 for an empty histogram.
+        // Concurrent record() calls may or may not be included.
+        value_type percentile(double p) const
+        {
+            assert(p >= 0.0 && p <= 100.0);
+
+            value_type total = 0;
+            for (const auto& bucket : m_buckets) {
+                total += bucket.load(std::memory_order_relaxed);
+            }
+            if (total == 0) return 0;
+
+            const auto target = std::max<value_type>(1, static_cast<value_type>(std::ceil(p / 100.0 * static_cast<double>(total))));
+            value_type seen = 0;
+            for (std::size_t n = 0; n < Bucket_Count; ++n) {
+                seen += m_buckets[n].load(std::memory_order_relaxed);
+                if (seen >= target) {
+                    return bucket_value(n);
+                }
+            }
+            return bucket_value(Bucket_Count - 1);
+        }
+
+        value_type min() const
+        {
+            for (std::size_t n = 0; n < Bucket_Count; ++n) {
+                if (m_buckets[n].load(std::memory_order_relaxed) != 0) return bucket_value(n);
+            }
+            return 0;
+        }
+
+        value_type max() const
+        {
+            for (std::size_t n = Bucket_Count; n-- > 0;) {
+                if (m_buckets[n].load(std::memory_order_relaxed) != 0) return bucket_value(n);
+            }
+            return 0;
+        }
+
+        static std::size_t bucket_index(value_type value)
+        {
+            if (value < 2 * Half_Bucket) {
+                return static_cast<std::size_t>(value);
+            }
+
+            // shift the value until only Precision_Bits are left
+            const std::size_t shift = detail::highest_bit(value) - (Precision_Bits - 1);
+            return shift * Half_Bucket + static_cast<std::size_t>(value >> shift);
+        }
+
+        // the middle of a bucket
+        static value_type bucket_value(std::size_t index)
+        {
+            if (index < 2 * Half_Bucket) {
+                return index;
+            }
+
+            const std::size_t shift = index / Half_Bucket - 1;
+            const value_type  sub   = index - shift * Half_Bucket;
+            const value_type  low   = sub << shift;
+            return low + ((value_type{ 1 } << shift) >> 1);
+        }
+
+    private:
+        std::array<std::atomic<value_type>, Bucket_Count> m_buckets = {};
+        std::atomic<value_type>                           m_count   = { 0 };
+    };
+}
+
+#endif // JUL_QUANTILES_H
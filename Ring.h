@@ -30,6 +30,8 @@ SOFTWARE.
 #include <array>
 #include <algorithm>
 
+#include "Parallel.h"
+
 namespace jul {
 
     // ---------------------------------------------------------------
@@ -60,10 +62,10 @@ namespace jul {
         Ring(const std::array<T, Size>& arr) : m_buffer{ arr } {}
 
         // operator
-        reference  operator[](size_type index)       { return m_buffer[index]; }
-        value_type operator[](size_type index) const { return m_buffer[index]; }
+        reference       operator[](size_type index)       { return m_buffer[index]; }
+        const_reference operator[](size_type index) const { return m_buffer[index]; }
 
-        value_type current() const { return m_buffer[m_index]; }
+        const_reference current() const { return m_buffer[m_index]; }
 
         // push a value at the current index;
         // true:  next value will overwrite an old value / index went over limit
@@ -72,6 +74,12 @@ namespace jul {
         {
             m_buffer[m_index] = value;
 
+            // power of two sizes wrap with a mask instead of a branch
+            if constexpr ((Size & (Size - 1)) == 0) {
+                m_index = (m_index + 1) & (Size - 1);
+                return m_index == 0;
+            }
+
             // has to overwrite from the beginning?
             if (m_index + 1 >= Size) {
                 m_index = 0;
@@ -84,12 +92,9 @@ namespace jul {
         }
 
         // does the Ring container that value?
-        bool contains(const_reference value)
+        bool contains(const_reference value) const
         {
-            for (auto v : m_buffer) {
-                if (v == value) return true;
-            }
-            return false;
+            return std::find(std::begin(m_buffer), std::end(m_buffer), value) != std::end(m_buffer);
         }
 
         // getter for the member variables
@@ -113,6 +118,24 @@ namespace jul {
             std::transform(std::begin(m_buffer), std::end(m_buffer), std::begin(m_buffer), fn);
         }
 
+        // apply_each in chunks of 'grain' values on a scheduler (see Parallel.h),
+        // small rings run sequentially
+        template <class Scheduler, class Function>
+        void apply_each_on(Scheduler& scheduler, Function&& fn, std::size_t grain = 0)
+        {
+            T* data = m_buffer.data();
+            chunked_for<T>(scheduler, Size, grain, [&](std::size_t first, std::size_t last) {
+                std::transform(data + first, data + last, data + first, fn);
+            });
+        }
+
+        template <class Function>
+        void parallel_apply_each(Function&& fn, std::size_t grain = 0)
+        {
+            Default_Scheduler scheduler;
+            apply_each_on(scheduler, std::forward<Function>(fn), grain);
+        }
+
     private:
         std::array<T, Size> m_buffer = {};
         size_type           m_index  = 0;
@@ -138,7 +161,7 @@ namespace jul {
     template <class T, std::size_t Size>
     bool contains(const Ring<T, Size>& ring, const T& value)
     {
-        return ring.conains(value);
+        return ring.contains(value);
     }
 
     template <class T, std::size_t SizeA, std::size_t SizeB>
@@ -0,0 +1,333 @@
+#ifndef JUL_SEARCH_H
+#define JUL_SEARCH_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <xmmintrin.h>
+#endif
+
+// -------------------------------------------------------------------
+// Lookups in sorted ranges (e.g. after jul::sort).
+// All functions expect the ranges to be sorted by the given predicate!
+// -------------------------------------------------------------------
+namespace jul {
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Hint for the CPU to load the cache line of address (for reading) while the
+    // current iteration still works. Never faults, any address is fine.
+    // ---------------------------------------------------------------------------------
+    inline void prefetch(const void* address)
+    {
+#if defined(_MSC_VER)
+        _mm_prefetch(static_cast<const char*>(address), _MM_HINT_T0);
+#else
+        __builtin_prefetch(address);
+#endif
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Branchless version of std::lower_bound for random access ranges.
+    // The loop always runs log2(n) times and the compiler emits a cmov instead of
+    // a branch, no mispredictions on random queries.
+    // Example:
+    // std::vector<int> v{ 1, 3, 5, 7 };
+    // auto it = branchless_lower_bound(std::begin(v), std::end(v), 4);
+    // => *it = 5
+    // ---------------------------------------------------------------------------------
+    template <class RandomIt, class T, class Compare = std::less<>>
+    RandomIt branchless_lower_bound(RandomIt first, RandomIt last, const T& value, Compare comp = {})
+    {
+        auto length = std::distance(first, last);
+        if (length == 0) return last;
+
+        while (length > 1) {
+            const auto half = length / 2;
+            first  = comp(first[half], value) ? first + half : first;
+            length = length - half;
+        }
+        return first + (comp(*first, value) ? 1 : 0);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Binary search (branchless) for a sorted container.
+    // ---------------------------------------------------------------------------------
+    template <class Container, class T, class Compare = std::less<>>
+    bool sorted_contains(const Container& c, const T& value, Compare comp = {})
+    {
+        auto it = branchless_lower_bound(std::begin(c), std::end(c), value, comp);
+        return it != std::end(c) && !comp(value, *it);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Lower bound for many queries at once. The queries are searched in interleaved
+    // groups, so the memory loads of one group overlap, and the next probes are
+    // prefetched. Returns the lower bound index (or size) for every query.
+    // Example:
+    // std::vector<int> sorted{ 1, 3, 5, 7 };
+    // auto found = batch_lower_bound(sorted, std::vector<int>{ 0, 5, 9 });
+    // => found = { 0, 2, 4 }
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Queries, class Compare = std::less<>>
+    std::vector<std::size_t> batch_lower_bound(const Container& sorted, const Queries& queries, Compare comp = {})
+    {
+        constexpr std::size_t Group_Size = 16;
+
+        const auto*       data  = std::data(sorted);
+        const std::size_t size  = std::size(sorted);
+        const std::size_t count = std::size(queries);
+
+        std::vector<std::size_t> result(count, 0);
+        if (size == 0) return result;
+
+        const auto* query = std::data(queries);
+        for (std::size_t group = 0; group < count; group += Group_Size) {
+            const std::size_t group_end = std::min(group + Group_Size, count);
+            std::size_t base[Group_Size] = {};
+
+            // every query of a group needs the same number of steps
+            for (std::size_t length = size; length > 1; length -= length / 2) {
+                const std::size_t half = length / 2;
+                for (std::size_t q = group; q < group_end; ++q) {
+                    auto& b = base[q - group];
+                    b = comp(data[b + half], query[q]) ? b + half : b;
+                    prefetch(data + b + (length - half) / 2); // next probe
+                }
+            }
+
+            for (std::size_t q = group; q < group_end; ++q) {
+                const auto b = base[q - group];
+                result[q] = b + (comp(data[b], query[q]) ? 1 : 0);
+            }
+        }
+
+        return result;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Eytzinger (class): sorted values stored in BFS order of an implicit binary tree.
+    // The first tree levels share a few cache lines and the children of a node are
+    // adjacent, so a lookup can prefetch 4 levels ahead. Faster than std::lower_bound
+    // for large arrays and many lookups, costs one extra copy of the keys.
+    // Example:
+    // Eytzinger<int> tree{ sorted_ints };
+    // std::size_t index = tree.lower_bound(42); // index into sorted_ints
+    // ---------------------------------------------------------------------------------
+    template <class T, class Compare = std::less<>>
+    class Eytzinger {
+    public:
+
+        using value_type = T;
+        using size_type  = std::size_t;
+
+        Eytzinger() = default;
+
+        // Precondition: values are sorted by Compare!
+        explicit Eytzinger(const std::vector<T>& sorted_values, Compare comp = {}) :
+            m_tree(std::size(sorted_values) + 1),
+            m_rank(std::size(sorted_values) + 1),
+            m_comp{ comp }
+        {
+            size_type next = 0;
+            build(sorted_values, next, 1);
+        }
+
+        // Index of the first value not less than 'value' in the original sorted
+        // vector, or size() if there is none.
+        size_type lower_bound(const T& value) const
+        {
+            const size_type k = find(value);
+            return k == 0 ? size() : m_rank[k];
+        }
+
+        bool contains(const T& value) const
+        {
+            const size_type k = find(value);
+            return k != 0 && !m_comp(value, m_tree[k]);
+        }
+
+        size_type size()  const { return std::size(m_tree) - 1; }
+        bool      empty() const { return size() == 0; }
+
+    private:
+
+        std::vector<T>         m_tree = { T{} }; // 1-based, index 0 is unused
+        std::vector<size_type> m_rank = { 0 };   // tree position -> sorted index
+        Compare                m_comp = {};
+
+        void build(const std::vector<T>& sorted_values, size_type& next, size_type k)
+        {
+            if (k > size()) return;
+
+            build(sorted_values, next, 2 * k);
+            m_tree[k] = sorted_values[next];
+            m_rank[k] = next++;
+            build(sorted_values, next, 2 * k + 1);
+        }
+
+        // tree position of the lower bound, 0 if there is none
+        size_type find(const T& value) const
+        {
+            const size_type n = size();
+            size_type k = 1;
+            while (k <= n) {
+                prefetch(m_tree.data() + std::min(k * 16, n));
+                k = 2 * k + (m_comp(m_tree[k], value) ? 1 : 0);
+            }
+
+            // undo the right turns after the last left turn
+            while (k & 1) k >>= 1;
+            return k >> 1;
+        }
+    };
+
+
+
+    namespace detail {
+
+        // first position in [first, last) where !comp(*it, value), probing 1, 2, 4, ... ahead
+        template <class RandomIt, class T, class Compare>
+        RandomIt gallop(RandomIt first, RandomIt last, const T& value, Compare& comp)
+        {
+            std::ptrdiff_t step = 1;
+            RandomIt low = first;
+            while (std::distance(low, last) > step && comp(low[step], value)) {
+                low  += step;
+                step *= 2;
+            }
+            const RandomIt high = std::distance(low, last) > step ? low + step + 1 : last;
+            return std::lower_bound(low, high, value, comp);
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Intersection of two sorted ranges (like std::set_intersection), but skips
+    // over non matching runs with exponential (galloping) search. Very fast when one
+    // range is much smaller than the other: O(m * log(n / m)) instead of O(m + n).
+    // Example:
+    // std::vector<int> out;
+    // galloping_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(out));
+    // ---------------------------------------------------------------------------------
+    template <class RandomItA, class RandomItB, class OutputIt, class Compare = std::less<>>
+    OutputIt galloping_intersection(RandomItA first_a, RandomItA last_a, RandomItB first_b, RandomItB last_b, OutputIt out, Compare comp = {})
+    {
+        while (first_a != last_a && first_b != last_b) {
+            if (comp(*first_a, *first_b)) {
+                first_a = detail::gallop(first_a, last_a, *first_b, comp);
+            }
+            else if (comp(*first_b, *first_a)) {
+                first_b = detail::gallop(first_b, last_b, *first_a, comp);
+            }
+            else {
+                *out++ = *first_a++;
+                ++first_b;
+            }
+        }
+        return out;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Union of two sorted ranges (like std::set_union). Runs that come from only one
+    // range are found with galloping search and copied as a block.
+    // ---------------------------------------------------------------------------------
+    template <class RandomItA, class RandomItB, class OutputIt, class Compare = std::less<>>
+    OutputIt galloping_union(RandomItA first_a, RandomItA last_a, RandomItB first_b, RandomItB last_b, OutputIt out, Compare comp = {})
+    {
+        while (first_a != last_a && first_b != last_b) {
+            if (comp(*first_a, *first_b)) {
+                const auto run_end = detail::gallop(first_a, last_a, *first_b, comp);
+                out = std::copy(first_a, run_end, out);
+                first_a = run_end;
+            }
+            else if (comp(*first_b, *first_a)) {
+                const auto run_end = detail::gallop(first_b, last_b, *first_a, comp);
+                out = std::copy(first_b, run_end, out);
+                first_b = run_end;
+            }
+            else {
+                *out++ = *first_a++;
+                ++first_b;
+            }
+        }
+        out = std::copy(first_a, last_a, out);
+        return std::copy(first_b, last_b, out);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Intersection of two sorted containers, returns a vector.
+    // Example:
+    // auto common = sorted_intersection(std::vector<int>{ 1, 2, 3 }, std::vector<int>{ 2, 3, 4 });
+    // => common = { 2, 3 }
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Compare = std::less<>>
+    std::vector<typename Container::value_type> sorted_intersection(const Container& a, const Container& b, Compare comp = {})
+    {
+        std::vector<typename Container::value_type> result;
+        result.reserve(std::min(std::size(a), std::size(b)));
+        galloping_intersection(std::begin(a), std::end(a), std::begin(b), std::end(b), std::back_inserter(result), comp);
+        return result;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Union of two sorted containers, returns a vector.
+    // Example:
+    // auto all = sorted_union(std::vector<int>{ 1, 2, 3 }, std::vector<int>{ 2, 3, 4 });
+    // => all = { 1, 2, 3, 4 }
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Compare = std::less<>>
+    std::vector<typename Container::value_type> sorted_union(const Container& a, const Container& b, Compare comp = {})
+    {
+        std::vector<typename Container::value_type> result;
+        result.reserve(std::size(a) + std::size(b));
+        galloping_union(std::begin(a), std::end(a), std::begin(b), std::end(b), std::back_inserter(result), comp);
+        return result;
+    }
+}
+
+#endif // JUL_SEARCH_H
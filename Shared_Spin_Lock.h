@@ -0,0 +1,263 @@
+#ifndef JUL_SHARED_SPIN_LOCK_H
+#define JUL_SHARED_SPIN_LOCK_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Parallel.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------
+    // Shared_Spin_Lock (class) = reader-writer spin lock for data that
+    // is read very often and written rarely.
+    // Readers count themselves on one of Shards counters (each on its
+    // own cache line), so readers on different cores do not write to
+    // the same line and read throughput scales with the cores.
+    // A writer sets its flag first (new readers back off, writers do
+    // not starve) and then waits until every shard is 0. Writing is
+    // more expensive the more shards there are.
+    // Works with std::shared_lock (readers) and std::unique_lock /
+    // std::lock_guard (writers).
+    //
+    // Example:
+    // Shared_Spin_Lock lock;
+    // { std::shared_lock<Shared_Spin_Lock> reader(lock); route = routes[key]; }
+    // { std::lock_guard<Shared_Spin_Lock>  writer(lock); routes[key] = route; }
+    // ---------------------------------------------------------------
+    class Shared_Spin_Lock final {
+    public:
+        static constexpr std::size_t Shards = 16;
+
+        Shared_Spin_Lock() = default;
+
+        Shared_Spin_Lock(const Shared_Spin_Lock&)            = delete;
+        Shared_Spin_Lock& operator=(const Shared_Spin_Lock&) = delete;
+
+        // writer
+        void lock()
+        {
+            Backoff backoff;
+            while (m_writer.load(std::memory_order_relaxed) || m_writer.exchange(true, std::memory_order_seq_cst)) {
+                backoff.pause();
+            }
+            // the flag is set, wait for the readers that came first
+            backoff.reset();
+            for (const Shard& shard : m_shards) {
+                while (shard.readers.load(std::memory_order_seq_cst) != 0) {
+                    backoff.pause();
+                }
+            }
+        }
+
+        bool try_lock()
+        {
+            if (m_writer.load(std::memory_order_relaxed) || m_writer.exchange(true, std::memory_order_seq_cst)) return false;
+
+            for (const Shard& shard : m_shards) {
+                if (shard.readers.load(std::memory_order_seq_cst) != 0) {
+                    m_writer.store(false, std::memory_order_release);
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        void unlock()
+        {
+            m_writer.store(false, std::memory_order_release);
+        }
+
+        // reader
+        void lock_shared()
+        {
+            Shard& shard = local_shard();
+            Backoff backoff;
+            while (!try_lock_shared(shard)) {
+                while (m_writer.load(std::memory_order_relaxed)) {
+                    backoff.pause();
+                }
+            }
+        }
+
+        bool try_lock_shared()
+        {
+            return try_lock_shared(local_shard());
+        }
+
+        void unlock_shared()
+        {
+            local_shard().readers.fetch_sub(1, std::memory_order_release);
+        }
+
+    private:
+        struct alignas(cache_line_size) Shard {
+            std::atomic<int> readers{ 0 };
+        };
+
+        alignas(cache_line_size) std::atomic<bool> m_writer{ false };
+        Shard m_shards[Shards];
+
+        // a thread always uses the same shard (lock_shared and unlock_shared must match)
+        Shard& local_shard() { return m_shards[thread_index() % Shards]; }
+
+        // Announce first, check the writer afterwards. Both sides are seq_cst, so
+        // either the writer sees the reader or the reader sees the writer.
+        bool try_lock_shared(Shard& shard)
+        {
+            shard.readers.fetch_add(1, std::memory_order_seq_cst);
+            if (!m_writer.load(std::memory_order_seq_cst)) return true;
+
+            shard.readers.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+    };
+
+
+
+    // ---------------------------------------------------------------
+    // Seq_Lock (class) = a small trivially copyable value that is read
+    // very often and written rarely.
+    // Readers do not write shared memory at all: they copy the value
+    // and retry if the sequence number was odd (write in progress) or
+    // changed while copying. Writers make the sequence odd, write and
+    // make it even again, concurrent writers wait for each other.
+    // Readers never block a writer, but a stream of writes makes the
+    // readers retry, keep T small (a few cache lines at most).
+    //
+    // Example:
+    // Seq_Lock<Config> config;
+    // config.store(new_config);               // rarely
+    // const Config current = config.load();   // hot path
+    // ---------------------------------------------------------------
+    template <class T>
+    class Seq_Lock final {
+    public:
+
+        static_assert(std::is_trivially_copyable<T>::value, "Seq_Lock copies raw bytes, T has to be trivially copyable!");
+
+        using value_type = T;
+
+        explicit Seq_Lock(const T& value = T{})
+        {
+            write(value);
+        }
+
+        Seq_Lock(const Seq_Lock&)            = delete;
+        Seq_Lock& operator=(const Seq_Lock&) = delete;
+
+        T load() const
+        {
+            Words copy;
+            Backoff backoff;
+            for (;;) {
+                const std::uint32_t before = m_sequence.load(std::memory_order_acquire);
+                if ((before & 1) == 0) {
+                    for (std::size_t n = 0; n < Word_Count; ++n) {
+                        copy[n] = m_words[n].load(std::memory_order_relaxed);
+                    }
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    if (m_sequence.load(std::memory_order_relaxed) == before) break;
+                }
+                backoff.pause();
+            }
+
+            T value;
+            std::memcpy(static_cast<void*>(&value), copy, sizeof(T));
+            return value;
+        }
+
+        void store(const T& value)
+        {
+            const std::uint32_t sequence = begin_write();
+            write(value);
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+        // Read-modify-write under the write lock: fn(T&) changes a copy that is stored afterwards.
+        template <class Fn>
+        void update(Fn&& fn)
+        {
+            const std::uint32_t sequence = begin_write();
+            T value = read();
+            fn(value);
+            write(value);
+            m_sequence.store(sequence + 2, std::memory_order_release);
+        }
+
+    private:
+        static constexpr std::size_t Word_Count = (sizeof(T) + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t);
+        using Words = std::uint64_t[Word_Count];
+
+        // T is stored in relaxed atomic words: a reader racing with a writer reads
+        // torn data (and throws it away), but it is no data race.
+        alignas(cache_line_size) std::atomic<std::uint32_t> m_sequence{ 0 };
+        std::atomic<std::uint64_t> m_words[Word_Count] = {};
+
+        // makes the sequence odd, returns the even value it had
+        std::uint32_t begin_write()
+        {
+            Backoff backoff;
+            std::uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+            for (;;) {
+                if ((sequence & 1) == 0 && m_sequence.compare_exchange_weak(sequence, sequence + 1, std::memory_order_acquire, std::memory_order_relaxed)) break;
+                backoff.pause();
+                sequence = m_sequence.load(std::memory_order_relaxed);
+            }
+            // the words must not become visible before the odd sequence
+            std::atomic_thread_fence(std::memory_order_release);
+            return sequence;
+        }
+
+        // only for the writer
+        T read() const
+        {
+            Words copy;
+            for (std::size_t n = 0; n < Word_Count; ++n) {
+                copy[n] = m_words[n].load(std::memory_order_relaxed);
+            }
+            T value;
+            std::memcpy(static_cast<void*>(&value), copy, sizeof(T));
+            return value;
+        }
+
+        void write(const T& value)
+        {
+            Words copy = {};
+            std::memcpy(copy, &value, sizeof(T));
+            for (std::size_t n = 0; n < Word_Count; ++n) {
+                m_words[n].store(copy[n], std::memory_order_relaxed);
+            }
+        }
+    };
+}
+
+#endif // JUL_SHARED_SPIN_LOCK_H
@@ -0,0 +1,478 @@
+#ifndef JUL_SIMD_H
+#define JUL_SIMD_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// -------------------------------------------------------------------
+// Minimal SIMD layer for the algorithms of this library.
+// The instruction set is chosen at compile time (-mavx2 / -mavx512f,
+// /arch:AVX2 / /arch:AVX512), without one every Pack is unavailable
+// and the algorithms use their scalar code.
+//
+// Pack<T> (if simd::available<T>):
+// Register                    - the vector register type
+// lanes                       - values per register
+// load(const T*)              - unaligned load of 'lanes' values
+// broadcast(T)                - register with all lanes = value
+// lt, gt, le, ge, eq(a, b)    - ordered compares, lane n -> bit n of a Mask
+// compress_store(out, m, r)   - stores the lanes selected by m contiguously
+//                               at out, returns their number. MAY WRITE all
+//                               'lanes' values, out needs room for them!
+//
+// Search<T> (if simd::searchable<T>, T = search_type_t of the value):
+// Register, lanes, load, broadcast - as above
+// eq(a, b)                    - Wide_Mask with 'bits_per_lane' bits per
+//                               equal lane (AVX2 sets one bit per byte)
+// -------------------------------------------------------------------
+namespace jul {
+namespace simd {
+
+    using Mask = std::uint32_t;
+
+    template <class T>
+    struct Pack;
+
+    template <class T>
+    inline constexpr bool available = false;
+
+    inline std::size_t popcount(Mask m)
+    {
+#if defined(_MSC_VER)
+        return __popcnt(m);
+#else
+        return static_cast<std::size_t>(__builtin_popcount(m));
+#endif
+    }
+
+    template <class T>
+    constexpr Mask full_mask() { return Pack<T>::lanes == 32 ? ~Mask{ 0 } : (Mask{ 1 } << Pack<T>::lanes) - 1; }
+
+
+
+    // equality search over 8 to 64 bit lanes
+    using Wide_Mask = std::uint64_t;
+
+    template <class T>
+    struct Search;
+
+    template <class T>
+    inline constexpr bool searchable = false;
+
+    template <std::size_t Bytes> struct Int_Of_Size    { using type = void; };
+    template <>                  struct Int_Of_Size<1> { using type = std::int8_t; };
+    template <>                  struct Int_Of_Size<2> { using type = std::int16_t; };
+    template <>                  struct Int_Of_Size<4> { using type = std::int32_t; };
+    template <>                  struct Int_Of_Size<8> { using type = std::int64_t; };
+
+    // Lane type of Search for T: integers are compared bitwise as signed integers of
+    // the same size, floating point values keep their type (NaN != NaN, -0 == 0).
+    template <class T>
+    using search_type_t = std::conditional_t<std::is_floating_point<T>::value, T,
+                          std::conditional_t<std::is_integral<T>::value && !std::is_same<T, bool>::value,
+                                             typename Int_Of_Size<sizeof(T)>::type, void>>;
+
+    inline std::size_t popcount(Wide_Mask m)
+    {
+#if defined(_MSC_VER)
+        return static_cast<std::size_t>(__popcnt64(m));
+#else
+        return static_cast<std::size_t>(__builtin_popcountll(m));
+#endif
+    }
+
+    // m != 0
+    inline std::size_t count_trailing_zeros(Wide_Mask m)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, m);
+        return index;
+#else
+        return static_cast<std::size_t>(__builtin_ctzll(m));
+#endif
+    }
+
+    // first equal lane of a non zero Search<T>::eq mask
+    template <class T>
+    std::size_t first_lane(Wide_Mask m) { return count_trailing_zeros(m) / Search<T>::bits_per_lane; }
+
+    // number of equal lanes of a Search<T>::eq mask
+    template <class T>
+    std::size_t lane_count(Wide_Mask m) { return popcount(m) / Search<T>::bits_per_lane; }
+
+
+
+#if defined(__AVX512F__)
+
+    // AVX-512: native mask registers and compress stores for 32 and 64 bit values
+
+    template <>
+    struct Pack<float> {
+        using Register = __m512;
+        static constexpr std::size_t lanes = 16;
+
+        static Register load(const float* p) { return _mm512_loadu_ps(p); }
+        static Register broadcast(float v)   { return _mm512_set1_ps(v); }
+        static Mask lt(Register a, Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+        static Mask gt(Register a, Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+        static Mask le(Register a, Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+        static Mask ge(Register a, Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+        static Mask eq(Register a, Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+        static std::size_t compress_store(float* out, Mask m, Register r)
+        {
+            _mm512_mask_compressstoreu_ps(out, static_cast<__mmask16>(m), r);
+            return popcount(m);
+        }
+    };
+
+    template <>
+    struct Pack<double> {
+        using Register = __m512d;
+        static constexpr std::size_t lanes = 8;
+
+        static Register load(const double* p) { return _mm512_loadu_pd(p); }
+        static Register broadcast(double v)   { return _mm512_set1_pd(v); }
+        static Mask lt(Register a, Register b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+        static Mask gt(Register a, Register b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+        static Mask le(Register a, Register b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+        static Mask ge(Register a, Register b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+        static Mask eq(Register a, Register b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+        static std::size_t compress_store(double* out, Mask m, Register r)
+        {
+            _mm512_mask_compressstoreu_pd(out, static_cast<__mmask8>(m), r);
+            return popcount(m);
+        }
+    };
+
+    template <>
+    struct Pack<std::int32_t> {
+        using Register = __m512i;
+        static constexpr std::size_t lanes = 16;
+
+        static Register load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+        static Register broadcast(std::int32_t v)   { return _mm512_set1_epi32(v); }
+        static Mask lt(Register a, Register b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_LT); }
+        static Mask gt(Register a, Register b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_NLE); }
+        static Mask le(Register a, Register b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_LE); }
+        static Mask ge(Register a, Register b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_NLT); }
+        static Mask eq(Register a, Register b) { return _mm512_cmp_epi32_mask(a, b, _MM_CMPINT_EQ); }
+        static std::size_t compress_store(std::int32_t* out, Mask m, Register r)
+        {
+            _mm512_mask_compressstoreu_epi32(out, static_cast<__mmask16>(m), r);
+            return popcount(m);
+        }
+    };
+
+    template <>
+    struct Pack<std::int64_t> {
+        using Register = __m512i;
+        static constexpr std::size_t lanes = 8;
+
+        static Register load(const std::int64_t* p) { return _mm512_loadu_si512(p); }
+        static Register broadcast(std::int64_t v)   { return _mm512_set1_epi64(v); }
+        static Mask lt(Register a, Register b) { return _mm512_cmp_epi64_mask(a, b, _MM_CMPINT_LT); }
+        static Mask gt(Register a, Register b) { return _mm512_cmp_epi64_mask(a, b, _MM_CMPINT_NLE); }
+        static Mask le(Register a, Register b) { return _mm512_cmp_epi64_mask(a, b, _MM_CMPINT_LE); }
+        static Mask ge(Register a, Register b) { return _mm512_cmp_epi64_mask(a, b, _MM_CMPINT_NLT); }
+        static Mask eq(Register a, Register b) { return _mm512_cmp_epi64_mask(a, b, _MM_CMPINT_EQ); }
+        static std::size_t compress_store(std::int64_t* out, Mask m, Register r)
+        {
+            _mm512_mask_compressstoreu_epi64(out, static_cast<__mmask8>(m), r);
+            return popcount(m);
+        }
+    };
+
+    template <> inline constexpr bool available<float>        = true;
+    template <> inline constexpr bool available<double>       = true;
+    template <> inline constexpr bool available<std::int32_t> = true;
+    template <> inline constexpr bool available<std::int64_t> = true;
+
+#elif defined(__AVX2__)
+
+    // AVX2: 8 x 32 bit, compress stores through a permutation table (8KB)
+
+    namespace detail {
+
+        struct Compress_Table {
+            std::int32_t index[256][8];
+            std::uint8_t count[256];
+        };
+
+        constexpr Compress_Table make_compress_table()
+        {
+            Compress_Table table = {};
+            for (int mask = 0; mask < 256; ++mask) {
+                int count = 0;
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (mask & (1 << bit)) {
+                        table.index[mask][count++] = bit;
+                    }
+                }
+                table.count[mask] = static_cast<std::uint8_t>(count);
+            }
+            return table;
+        }
+
+        inline constexpr Compress_Table compress_table = make_compress_table();
+
+        inline std::size_t compress_store(void* out, Mask m, __m256i r)
+        {
+            const auto index = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(compress_table.index[m]));
+            _mm256_storeu_si256(static_cast<__m256i*>(out), _mm256_permutevar8x32_epi32(r, index));
+            return compress_table.count[m];
+        }
+    }
+
+    template <>
+    struct Pack<float> {
+        using Register = __m256;
+        static constexpr std::size_t lanes = 8;
+
+        static Register load(const float* p) { return _mm256_loadu_ps(p); }
+        static Register broadcast(float v)   { return _mm256_set1_ps(v); }
+        static Mask lt(Register a, Register b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LT_OQ)); }
+        static Mask gt(Register a, Register b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+        static Mask le(Register a, Register b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+        static Mask ge(Register a, Register b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_GE_OQ)); }
+        static Mask eq(Register a, Register b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)); }
+        static std::size_t compress_store(float* out, Mask m, Register r)
+        {
+            return detail::compress_store(out, m, _mm256_castps_si256(r));
+        }
+    };
+
+    template <>
+    struct Pack<std::int32_t> {
+        using Register = __m256i;
+        static constexpr std::size_t lanes = 8;
+
+        static Register load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static Register broadcast(std::int32_t v)   { return _mm256_set1_epi32(v); }
+        static Mask gt(Register a, Register b) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(a, b))); }
+        static Mask lt(Register a, Register b) { return gt(b, a); }
+        static Mask le(Register a, Register b) { return ~gt(a, b) & 0xFF; }
+        static Mask ge(Register a, Register b) { return ~gt(b, a) & 0xFF; }
+        static Mask eq(Register a, Register b) { return _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(a, b))); }
+        static std::size_t compress_store(std::int32_t* out, Mask m, Register r)
+        {
+            return detail::compress_store(out, m, r);
+        }
+    };
+
+    template <> inline constexpr bool available<float>        = true;
+    template <> inline constexpr bool available<std::int32_t> = true;
+
+#endif
+
+
+
+#if defined(__AVX512BW__)
+
+    // AVX-512BW: 64 x 8 bit and 32 x 16 bit compares with mask registers
+
+    template <>
+    struct Search<std::int8_t> {
+        using Register = __m512i;
+        static constexpr std::size_t lanes         = 64;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const std::int8_t* p) { return _mm512_loadu_si512(p); }
+        static Register broadcast(std::int8_t v)   { return _mm512_set1_epi8(v); }
+        static Wide_Mask eq(Register a, Register b) { return _mm512_cmpeq_epi8_mask(a, b); }
+    };
+
+    template <>
+    struct Search<std::int16_t> {
+        using Register = __m512i;
+        static constexpr std::size_t lanes         = 32;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const std::int16_t* p) { return _mm512_loadu_si512(p); }
+        static Register broadcast(std::int16_t v)   { return _mm512_set1_epi16(v); }
+        static Wide_Mask eq(Register a, Register b) { return _mm512_cmpeq_epi16_mask(a, b); }
+    };
+
+    template <> inline constexpr bool searchable<std::int8_t>  = true;
+    template <> inline constexpr bool searchable<std::int16_t> = true;
+
+#elif defined(__AVX2__)
+
+    // AVX2: byte masks (movemask_epi8), so a 16 bit lane sets 2 bits
+
+    template <>
+    struct Search<std::int8_t> {
+        using Register = __m256i;
+        static constexpr std::size_t lanes         = 32;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const std::int8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static Register broadcast(std::int8_t v)   { return _mm256_set1_epi8(v); }
+        static Wide_Mask eq(Register a, Register b) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(a, b))); }
+    };
+
+    template <>
+    struct Search<std::int16_t> {
+        using Register = __m256i;
+        static constexpr std::size_t lanes         = 16;
+        static constexpr std::size_t bits_per_lane = 2;
+
+        static Register load(const std::int16_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static Register broadcast(std::int16_t v)   { return _mm256_set1_epi16(v); }
+        static Wide_Mask eq(Register a, Register b) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(a, b))); }
+    };
+
+    template <> inline constexpr bool searchable<std::int8_t>  = true;
+    template <> inline constexpr bool searchable<std::int16_t> = true;
+
+#endif
+
+
+
+#if defined(__AVX512F__)
+
+    // AVX-512F: 16 x 32 bit and 8 x 64 bit compares with mask registers
+
+    template <>
+    struct Search<std::int32_t> {
+        using Register = __m512i;
+        static constexpr std::size_t lanes         = 16;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const std::int32_t* p) { return _mm512_loadu_si512(p); }
+        static Register broadcast(std::int32_t v)   { return _mm512_set1_epi32(v); }
+        static Wide_Mask eq(Register a, Register b) { return _mm512_cmpeq_epi32_mask(a, b); }
+    };
+
+    template <>
+    struct Search<std::int64_t> {
+        using Register = __m512i;
+        static constexpr std::size_t lanes         = 8;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const std::int64_t* p) { return _mm512_loadu_si512(p); }
+        static Register broadcast(std::int64_t v)   { return _mm512_set1_epi64(v); }
+        static Wide_Mask eq(Register a, Register b) { return _mm512_cmpeq_epi64_mask(a, b); }
+    };
+
+    template <>
+    struct Search<float> {
+        using Register = __m512;
+        static constexpr std::size_t lanes         = 16;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const float* p) { return _mm512_loadu_ps(p); }
+        static Register broadcast(float v)   { return _mm512_set1_ps(v); }
+        static Wide_Mask eq(Register a, Register b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+    };
+
+    template <>
+    struct Search<double> {
+        using Register = __m512d;
+        static constexpr std::size_t lanes         = 8;
+        static constexpr std::size_t bits_per_lane = 1;
+
+        static Register load(const double* p) { return _mm512_loadu_pd(p); }
+        static Register broadcast(double v)   { return _mm512_set1_pd(v); }
+        static Wide_Mask eq(Register a, Register b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+    };
+
+    template <> inline constexpr bool searchable<std::int32_t> = true;
+    template <> inline constexpr bool searchable<std::int64_t> = true;
+    template <> inline constexpr bool searchable<float>        = true;
+    template <> inline constexpr bool searchable<double>       = true;
+
+#elif defined(__AVX2__)
+
+    // AVX2: byte masks, 4 (32 bit) or 8 (64 bit) bits per lane
+
+    template <>
+    struct Search<std::int32_t> {
+        using Register = __m256i;
+        static constexpr std::size_t lanes         = 8;
+        static constexpr std::size_t bits_per_lane = 4;
+
+        static Register load(const std::int32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static Register broadcast(std::int32_t v)   { return _mm256_set1_epi32(v); }
+        static Wide_Mask eq(Register a, Register b) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi32(a, b))); }
+    };
+
+    template <>
+    struct Search<std::int64_t> {
+        using Register = __m256i;
+        static constexpr std::size_t lanes         = 4;
+        static constexpr std::size_t bits_per_lane = 8;
+
+        static Register load(const std::int64_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+        static Register broadcast(std::int64_t v)   { return _mm256_set1_epi64x(v); }
+        static Wide_Mask eq(Register a, Register b) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi64(a, b))); }
+    };
+
+    template <>
+    struct Search<float> {
+        using Register = __m256;
+        static constexpr std::size_t lanes         = 8;
+        static constexpr std::size_t bits_per_lane = 4;
+
+        static Register load(const float* p) { return _mm256_loadu_ps(p); }
+        static Register broadcast(float v)   { return _mm256_set1_ps(v); }
+        static Wide_Mask eq(Register a, Register b) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_EQ_OQ)))); }
+    };
+
+    template <>
+    struct Search<double> {
+        using Register = __m256d;
+        static constexpr std::size_t lanes         = 4;
+        static constexpr std::size_t bits_per_lane = 8;
+
+        static Register load(const double* p) { return _mm256_loadu_pd(p); }
+        static Register broadcast(double v)   { return _mm256_set1_pd(v); }
+        static Wide_Mask eq(Register a, Register b) { return static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_castpd_si256(_mm256_cmp_pd(a, b, _CMP_EQ_OQ)))); }
+    };
+
+    template <> inline constexpr bool searchable<std::int32_t> = true;
+    template <> inline constexpr bool searchable<std::int64_t> = true;
+    template <> inline constexpr bool searchable<float>        = true;
+    template <> inline constexpr bool searchable<double>       = true;
+
+#endif
+
+}
+}
+
+#endif // JUL_SIMD_H
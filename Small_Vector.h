@@ -0,0 +1,378 @@
+#ifndef JUL_SMALL_VECTOR_H
+#define JUL_SMALL_VECTOR_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstring>
+#include <initializer_list>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "Vector_Ext.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------------------------
+    // Can an object be moved to a new address with memcpy (and without calling the
+    // destructor of the old one)? True for all trivially copyable types, specialize it
+    // for own types that don't point into themselves.
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+    template <class T>
+    inline constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Small_Vector (class) = std::vector with inline storage for N elements.
+    // Only allocates when it grows over N elements, after that it behaves like a
+    // std::vector. Trivially relocatable types are moved with memcpy when the
+    // storage changes.
+    // Works with all Vector_Ext.h functions (see jul::is_vector_like).
+    // Example:
+    // Small_Vector<int, 16> ids = { 1, 2, 3 }; // no allocation
+    // ids.push_back(4);
+    // bool has_two = contains(ids, 2);
+    // ---------------------------------------------------------------------------------
+    template <class T, std::size_t N>
+    class Small_Vector {
+    public:
+
+        static_assert(N > 0, "A Small_Vector needs inline storage, use std::vector for N = 0!");
+
+        // member types
+        using value_type      = T;
+        using size_type       = std::size_t;
+        using difference_type = std::ptrdiff_t;
+        using reference       = value_type&;
+        using const_reference = const value_type&;
+        using pointer         = value_type*;
+        using const_pointer   = const value_type*;
+        using iterator        = value_type*;
+        using const_iterator  = const value_type*;
+
+        static constexpr size_type inline_capacity = N;
+
+        // constructor
+        Small_Vector() = default;
+
+        explicit Small_Vector(size_type count) { resize(count); }
+
+        Small_Vector(size_type count, const T& value) { resize(count, value); }
+
+        Small_Vector(std::initializer_list<T> values) : Small_Vector(std::begin(values), std::end(values)) {}
+
+        template <class InputIt, class = typename std::iterator_traits<InputIt>::iterator_category>
+        Small_Vector(InputIt first, InputIt last)
+        {
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+        }
+
+        Small_Vector(const Small_Vector& other)
+        {
+            reserve(other.size());
+            std::uninitialized_copy(other.begin(), other.end(), data());
+            m_size = other.size();
+        }
+
+        Small_Vector(Small_Vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            take(std::move(other));
+        }
+
+        ~Small_Vector()
+        {
+            clear();
+            release_heap();
+        }
+
+        Small_Vector& operator=(const Small_Vector& other)
+        {
+            if (this != &other) {
+                clear();
+                reserve(other.size());
+                std::uninitialized_copy(other.begin(), other.end(), data());
+                m_size = other.size();
+            }
+            return *this;
+        }
+
+        Small_Vector& operator=(Small_Vector&& other) noexcept(std::is_nothrow_move_constructible<T>::value)
+        {
+            if (this != &other) {
+                clear();
+                release_heap();
+                take(std::move(other));
+            }
+            return *this;
+        }
+
+        Small_Vector& operator=(std::initializer_list<T> values)
+        {
+            clear();
+            for (const auto& value : values) {
+                push_back(value);
+            }
+            return *this;
+        }
+
+        // element access
+        reference       operator[](size_type n)       { assert(n < m_size); return data()[n]; }
+        const_reference operator[](size_type n) const { assert(n < m_size); return data()[n]; }
+
+        reference at(size_type n)
+        {
+            if (n >= m_size) throw std::out_of_range("Small_Vector::at");
+            return data()[n];
+        }
+
+        const_reference at(size_type n) const
+        {
+            if (n >= m_size) throw std::out_of_range("Small_Vector::at");
+            return data()[n];
+        }
+
+        reference       front()       { assert(!empty()); return data()[0]; }
+        const_reference front() const { assert(!empty()); return data()[0]; }
+        reference       back()        { assert(!empty()); return data()[m_size - 1]; }
+        const_reference back()  const { assert(!empty()); return data()[m_size - 1]; }
+
+        pointer       data()       { return m_heap ? m_heap : inline_data(); }
+        const_pointer data() const { return m_heap ? m_heap : inline_data(); }
+
+        // iterators
+        iterator       begin()        { return data(); }
+        iterator       end()          { return data() + m_size; }
+        const_iterator begin()  const { return data(); }
+        const_iterator end()    const { return data() + m_size; }
+        const_iterator cbegin() const { return data(); }
+        const_iterator cend()   const { return data() + m_size; }
+
+        // capacity
+        bool      empty()     const { return m_size == 0; }
+        size_type size()      const { return m_size; }
+        size_type capacity()  const { return m_capacity; }
+        bool      is_inline() const { return m_heap == nullptr; }
+
+        void reserve(size_type new_capacity)
+        {
+            if (new_capacity > m_capacity) {
+                reallocate(new_capacity);
+            }
+        }
+
+        void shrink_to_fit()
+        {
+            if (m_heap && m_size <= N) {
+                T* heap = m_heap;
+                m_heap = nullptr;
+                relocate(heap, m_size, inline_data());
+                ::operator delete(heap);
+                m_capacity = N;
+            }
+            else if (m_heap && m_size < m_capacity) {
+                reallocate(m_size);
+            }
+        }
+
+        // modifiers
+        void clear()
+        {
+            std::destroy(begin(), end());
+            m_size = 0;
+        }
+
+        void push_back(const T& value) { emplace_back(value); }
+        void push_back(T&& value)      { emplace_back(std::move(value)); }
+
+        template <class... Args>
+        reference emplace_back(Args&&... args)
+        {
+            if (m_size == m_capacity) {
+                // the argument could live in this vector, construct it before relocating
+                T value(std::forward<Args>(args)...);
+                reallocate(m_capacity * 2);
+                return *::new (static_cast<void*>(data() + m_size++)) T(std::move(value));
+            }
+            return *::new (static_cast<void*>(data() + m_size++)) T(std::forward<Args>(args)...);
+        }
+
+        void pop_back()
+        {
+            assert(!empty());
+            std::destroy_at(data() + --m_size);
+        }
+
+        void resize(size_type count)
+        {
+            resize_with(count, [](T* p) { ::new (static_cast<void*>(p)) T(); });
+        }
+
+        void resize(size_type count, const T& value)
+        {
+            resize_with(count, [&](T* p) { ::new (static_cast<void*>(p)) T(value); });
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return erase(pos, pos + 1);
+        }
+
+        iterator erase(const_iterator first, const_iterator last)
+        {
+            iterator begin_erase = begin() + (first - cbegin());
+            iterator end_erase   = begin() + (last - cbegin());
+            iterator new_end     = std::move(end_erase, end(), begin_erase);
+            std::destroy(new_end, end());
+            m_size = static_cast<size_type>(new_end - begin());
+            return begin_erase;
+        }
+
+        template <class InputIt, class = typename std::iterator_traits<InputIt>::iterator_category>
+        iterator insert(const_iterator pos, InputIt first, InputIt last)
+        {
+            const size_type offset = static_cast<size_type>(pos - cbegin());
+            const size_type old_size = m_size;
+            for (; first != last; ++first) {
+                emplace_back(*first);
+            }
+            std::rotate(begin() + offset, begin() + old_size, end());
+            return begin() + offset;
+        }
+
+        iterator insert(const_iterator pos, const T& value)
+        {
+            const size_type offset = static_cast<size_type>(pos - cbegin());
+            emplace_back(value);
+            std::rotate(begin() + offset, end() - 1, end());
+            return begin() + offset;
+        }
+
+        void swap(Small_Vector& other)
+        {
+            Small_Vector temp = std::move(other);
+            other = std::move(*this);
+            *this = std::move(temp);
+        }
+
+        // compare
+        bool operator==(const Small_Vector& other) const { return std::equal(begin(), end(), other.begin(), other.end()); }
+        bool operator!=(const Small_Vector& other) const { return !(*this == other); }
+
+    private:
+        alignas(T) unsigned char m_inline[N * sizeof(T)];
+        T*        m_heap     = nullptr;
+        size_type m_size     = 0;
+        size_type m_capacity = N;
+
+        T*       inline_data()       { return std::launder(reinterpret_cast<T*>(m_inline)); }
+        const T* inline_data() const { return std::launder(reinterpret_cast<const T*>(m_inline)); }
+
+        // moves count objects from src to the uninitialized dst and ends their lifetime in src
+        static void relocate(T* src, size_type count, T* dst)
+        {
+            if constexpr (is_trivially_relocatable_v<T>) {
+                if (count != 0) {
+                    std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src), count * sizeof(T));
+                }
+            }
+            else {
+                std::uninitialized_move(src, src + count, dst);
+                std::destroy(src, src + count);
+            }
+        }
+
+        void reallocate(size_type new_capacity)
+        {
+            assert(new_capacity >= m_size);
+            T* heap = static_cast<T*>(::operator new(new_capacity * sizeof(T)));
+            relocate(data(), m_size, heap);
+            release_heap();
+            m_heap     = heap;
+            m_capacity = new_capacity;
+        }
+
+        void release_heap()
+        {
+            if (m_heap) {
+                ::operator delete(m_heap);
+                m_heap     = nullptr;
+                m_capacity = N;
+            }
+        }
+
+        // this is empty and inline
+        void take(Small_Vector&& other)
+        {
+            if (other.m_heap) {
+                m_heap     = std::exchange(other.m_heap, nullptr);
+                m_capacity = std::exchange(other.m_capacity, N);
+            }
+            else {
+                relocate(other.inline_data(), other.m_size, inline_data());
+            }
+            m_size = std::exchange(other.m_size, 0);
+        }
+
+        template <class Construct>
+        void resize_with(size_type count, Construct&& construct)
+        {
+            if (count < m_size) {
+                std::destroy(begin() + count, end());
+                m_size = count;
+                return;
+            }
+
+            reserve(count);
+            for (; m_size < count; ++m_size) {
+                construct(data() + m_size);
+            }
+        }
+    };
+
+
+
+    // a Small_Vector is relocatable whenever its elements are (it never points into itself)
+    template <class T, std::size_t N>
+    struct is_trivially_relocatable<Small_Vector<T, N>> : is_trivially_relocatable<T> {};
+
+    // all Vector_Ext.h functions accept a Small_Vector
+    template <class T, std::size_t N>
+    struct is_vector_like<Small_Vector<T, N>> : std::true_type {};
+}
+
+#endif // JUL_SMALL_VECTOR_H
@@ -0,0 +1,262 @@
+#ifndef JUL_SOA_H
+#define JUL_SOA_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Sort.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------------------------
+    // Soa (class) = struct of arrays
+    // Stores every field in its own contiguous std::vector, so a loop over one field
+    // only loads that field. A row is a tuple of references into the columns.
+    // The columns are plain vectors and work with all Vector_Ext.h functions.
+    // Example:
+    // Soa<int, float> particles;          // id, mass
+    // particles.push_back(1, 0.5f);
+    // particles.push_back(2, 2.0f);
+    //
+    // auto mass = jul::stats(particles.column<1>());
+    // particles.sort_by<1>();            // argsort + permutation of all columns
+    // for (auto [id, m] : particles) { m *= 2.0f; }
+    // ---------------------------------------------------------------------------------
+    template <class... Fields>
+    class Soa {
+    public:
+
+        static_assert(sizeof...(Fields) > 0, "A Soa needs at least one field!");
+        static_assert(!(std::is_same<Fields, bool>::value || ...), "std::vector<bool> has no bool& for a row, use char or std::uint8_t fields!");
+
+        // member types
+        using value_type          = std::tuple<Fields...>;
+        using size_type           = std::size_t;
+        using reference           = std::tuple<Fields&...>;
+        using const_reference     = std::tuple<const Fields&...>;
+
+        template <std::size_t I>
+        using field_type = std::tuple_element_t<I, value_type>;
+
+        static constexpr size_type field_count = sizeof...(Fields);
+
+        // row iterator, dereferences to a tuple of references
+        template <class Owner, class Reference>
+        class Row_Iterator {
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type        = Soa::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using reference         = Reference;
+            using pointer           = void;
+
+            Row_Iterator() = default;
+            Row_Iterator(Owner* owner, size_type index) : m_owner{ owner }, m_index{ index } {}
+
+            reference operator*() const                   { return (*m_owner)[m_index]; }
+            reference operator[](difference_type n) const { return (*m_owner)[m_index + n]; }
+
+            Row_Iterator& operator++()    { ++m_index; return *this; }
+            Row_Iterator& operator--()    { --m_index; return *this; }
+            Row_Iterator  operator++(int) { auto copy = *this; ++m_index; return copy; }
+            Row_Iterator  operator--(int) { auto copy = *this; --m_index; return copy; }
+
+            Row_Iterator& operator+=(difference_type n) { m_index += n; return *this; }
+            Row_Iterator& operator-=(difference_type n) { m_index -= n; return *this; }
+            Row_Iterator  operator+(difference_type n) const { return { m_owner, m_index + n }; }
+            Row_Iterator  operator-(difference_type n) const { return { m_owner, m_index - n }; }
+            difference_type operator-(const Row_Iterator& other) const
+            {
+                return static_cast<difference_type>(m_index) - static_cast<difference_type>(other.m_index);
+            }
+
+            bool operator==(const Row_Iterator& other) const { return m_index == other.m_index; }
+            bool operator!=(const Row_Iterator& other) const { return m_index != other.m_index; }
+            bool operator< (const Row_Iterator& other) const { return m_index <  other.m_index; }
+            bool operator> (const Row_Iterator& other) const { return m_index >  other.m_index; }
+            bool operator<=(const Row_Iterator& other) const { return m_index <= other.m_index; }
+            bool operator>=(const Row_Iterator& other) const { return m_index >= other.m_index; }
+
+            friend Row_Iterator operator+(difference_type n, const Row_Iterator& it) { return it + n; }
+
+        private:
+            Owner*    m_owner = nullptr;
+            size_type m_index = 0;
+        };
+
+        using iterator       = Row_Iterator<Soa, reference>;
+        using const_iterator = Row_Iterator<const Soa, const_reference>;
+
+        // constructor
+        Soa() = default;
+        explicit Soa(size_type size) { resize(size); }
+
+        // rows
+        reference operator[](size_type n)
+        {
+            assert(n < size() && "Index is out of range!");
+            return get_row(n, std::index_sequence_for<Fields...>{});
+        }
+
+        const_reference operator[](size_type n) const
+        {
+            assert(n < size() && "Index is out of range!");
+            return get_row(n, std::index_sequence_for<Fields...>{});
+        }
+
+        void push_back(Fields... values)
+        {
+            push_row(std::index_sequence_for<Fields...>{}, std::move(values)...);
+        }
+
+        void push_back(const value_type& row)
+        {
+            std::apply([this](const Fields&... values) { push_back(values...); }, row);
+        }
+
+        void pop_back()
+        {
+            assert(!empty());
+            for_each_column([](auto& column) { column.pop_back(); });
+        }
+
+        // Columns: contiguous storage of one field. Don't change the size of a column,
+        // all columns must have the same size!
+        template <std::size_t I>
+        std::vector<field_type<I>>& column() { return std::get<I>(m_columns); }
+
+        template <std::size_t I>
+        const std::vector<field_type<I>>& column() const { return std::get<I>(m_columns); }
+
+        template <std::size_t I>
+        field_type<I>* column_data() { return std::get<I>(m_columns).data(); }
+
+        template <std::size_t I>
+        const field_type<I>* column_data() const { return std::get<I>(m_columns).data(); }
+
+        // capacity
+        size_type size()  const { return std::size(std::get<0>(m_columns)); }
+        bool      empty() const { return size() == 0; }
+
+        void reserve(size_type capacity) { for_each_column([=](auto& column) { column.reserve(capacity); }); }
+        void resize(size_type size)      { for_each_column([=](auto& column) { column.resize(size); }); }
+        void clear()                     { for_each_column([](auto& column) { column.clear(); }); }
+
+        // Reorders all columns, afterwards row n is the old row order[n] (see jul::argsort).
+        void apply_permutation(const std::vector<std::size_t>& order)
+        {
+            std::apply([&](auto&... columns) { jul::apply_permutation(order, columns...); }, m_columns);
+        }
+
+        // Sorts all rows by the field I. Only the keys are sorted (jul::argsort),
+        // the columns are reordered once afterwards.
+        template <std::size_t I>
+        void sort_by()
+        {
+            apply_permutation(jul::argsort(column<I>()));
+        }
+
+        template <std::size_t I, class Compare>
+        void sort_by(Compare comp)
+        {
+            const auto& keys = column<I>();
+
+            std::vector<std::size_t> order(size());
+            std::iota(std::begin(order), std::end(order), std::size_t{ 0 });
+            std::stable_sort(std::begin(order), std::end(order), [&](std::size_t a, std::size_t b) { return comp(keys[a], keys[b]); });
+            apply_permutation(order);
+        }
+
+        // Removes all rows for which pred(row) is true, pred gets a const_reference.
+        template <class Predicate>
+        void remove_if(Predicate&& pred)
+        {
+            const size_type count = size();
+            size_type kept = 0;
+            for (size_type n = 0; n < count; ++n) {
+                if (pred(std::as_const(*this)[n])) continue;
+                if (kept != n) {
+                    move_row(n, kept, std::index_sequence_for<Fields...>{});
+                }
+                ++kept;
+            }
+            resize(kept);
+        }
+
+        // iterators
+        iterator       begin()        { return { this, 0 }; }
+        iterator       end()          { return { this, size() }; }
+        const_iterator begin()  const { return { this, 0 }; }
+        const_iterator end()    const { return { this, size() }; }
+        const_iterator cbegin() const { return { this, 0 }; }
+        const_iterator cend()   const { return { this, size() }; }
+
+    private:
+        std::tuple<std::vector<Fields>...> m_columns;
+
+        template <class Function>
+        void for_each_column(Function&& fn)
+        {
+            std::apply([&](auto&... columns) { (fn(columns), ...); }, m_columns);
+        }
+
+        template <std::size_t... I>
+        reference get_row(size_type n, std::index_sequence<I...>)
+        {
+            return reference{ std::get<I>(m_columns)[n]... };
+        }
+
+        template <std::size_t... I>
+        const_reference get_row(size_type n, std::index_sequence<I...>) const
+        {
+            return const_reference{ std::get<I>(m_columns)[n]... };
+        }
+
+        template <std::size_t... I>
+        void push_row(std::index_sequence<I...>, Fields&&... values)
+        {
+            (std::get<I>(m_columns).push_back(std::move(values)), ...);
+        }
+
+        template <std::size_t... I>
+        void move_row(size_type from, size_type to, std::index_sequence<I...>)
+        {
+            ((std::get<I>(m_columns)[to] = std::move(std::get<I>(m_columns)[from])), ...);
+        }
+    };
+}
+
+#endif // JUL_SOA_H
@@ -29,7 +29,18 @@ SOFTWARE.
 
 
 #include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <execution>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Parallel.h"
 
 namespace jul 
 {
@@ -62,14 +73,30 @@ namespace jul
 
     // ----------------------------------------------------------
     // Is a container sorted? Wrapper for std::is_sorted.
+    // Runs in parallel for containers above jul::parallel_threshold.
     // Example:
     // assert(is_sorted(std::vector<int>{ 0, 1, 2, 3 }));
     // assert(is_sorted(std::set<int>{ 5, 1, 4, 3 }));
     // ----------------------------------------------------------
-    template <class Container>
-    constexpr bool is_sorted(const Container& c)
+    template <class Container, class = std::enable_if_t<!is_execution_policy_v<Container>>>
+    bool is_sorted(const Container& c)
     {
-        return std::is_sorted(std::execution::par, std::begin(c), std::end(c));
+        return with_policy(std::size(c), [&](auto policy) {
+            return std::is_sorted(policy, std::begin(c), std::end(c));
+        });
+    }
+
+
+
+    // ----------------------------------------------------------
+    // Is a container sorted? Uses an explicit execution policy.
+    // Example:
+    // assert(is_sorted(std::execution::seq, ints));
+    // ----------------------------------------------------------
+    template <class Policy, class Container, class = std::enable_if_t<is_execution_policy_v<Policy>>>
+    bool is_sorted(Policy&& policy, const Container& c)
+    {
+        return std::is_sorted(policy, std::begin(c), std::end(c));
     }
 
 
@@ -89,22 +116,82 @@ namespace jul
 
     // ---------------------------------------------------------------------------------
     // Wrapper for std::sort for a complete container.
+    // Runs in parallel for containers above jul::parallel_threshold.
     // ---------------------------------------------------------------------------------
-    template <class Container>
+    template <class Container, class = std::enable_if_t<!is_execution_policy_v<Container>>>
     void sort(Container& c)
     {
-        std::sort(std::execution::par, std::begin(c), std::end(c));
+        with_policy(std::size(c), [&](auto policy) {
+            std::sort(policy, std::begin(c), std::end(c));
+        });
     }
 
 
 
     // ---------------------------------------------------------------------------------
     // Wrapper for std::sort for a complete container with a custom predicate.
+    // Runs in parallel for containers above jul::parallel_threshold.
     // ---------------------------------------------------------------------------------
-    template <class Container, class Predicate>
+    template <class Container, class Predicate, class = std::enable_if_t<!is_execution_policy_v<Container>>>
     void sort(Container& c, Predicate&& pred)
     {
-        std::sort(std::execution::par, std::begin(c), std::end(c), pred);
+        with_policy(std::size(c), [&](auto policy) {
+            std::sort(policy, std::begin(c), std::end(c), pred);
+        });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Wrapper for std::sort for a complete container with an explicit execution policy.
+    // Example:
+    // jul::sort(std::execution::seq, ints);
+    // jul::sort(std::execution::par_unseq, ints, std::greater<>{});
+    // ---------------------------------------------------------------------------------
+    template <class Policy, class Container, class Predicate = std::less<>, class = std::enable_if_t<is_execution_policy_v<Policy>>>
+    void sort(Policy&& policy, Container& c, Predicate&& pred = {})
+    {
+        std::sort(policy, std::begin(c), std::end(c), pred);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Sort a complete container on a user supplied scheduler (see Parallel.h).
+    // The chunks are sorted as independent tasks and merged pairwise afterwards,
+    // so the sort never touches the std::execution thread pool.
+    // Example:
+    // jul::sort_on(my_pool, ints);
+    // ---------------------------------------------------------------------------------
+    template <class Scheduler, class Container, class Predicate = std::less<>>
+    void sort_on(Scheduler& scheduler, Container& c, Predicate&& pred = {}, std::size_t threshold = parallel_threshold)
+    {
+        const std::size_t size = std::size(c);
+        if (size < threshold) {
+            std::sort(std::begin(c), std::end(c), pred);
+            return;
+        }
+
+        const std::size_t chunks = std::min<std::size_t>(hardware_threads(), size / std::max<std::size_t>(threshold / 2, 1));
+        auto bound = [&](std::size_t n) { return std::next(std::begin(c), size * n / chunks); };
+
+        scheduler.parallel_for(0, chunks, 1, [&](std::size_t first, std::size_t last) {
+            for (std::size_t n = first; n < last; ++n) {
+                std::sort(bound(n), bound(n + 1), pred);
+            }
+        });
+
+        for (std::size_t width = 1; width < chunks; width *= 2) {
+            const std::size_t merges = (chunks + 2 * width - 1) / (2 * width);
+            scheduler.parallel_for(0, merges, 1, [&](std::size_t first, std::size_t last) {
+                for (std::size_t n = first; n < last; ++n) {
+                    const std::size_t left = n * 2 * width;
+                    const std::size_t mid  = std::min(left + width, chunks);
+                    const std::size_t end  = std::min(left + 2 * width, chunks);
+                    std::inplace_merge(bound(left), bound(mid), bound(end), pred);
+                }
+            });
+        }
     }
 
 
@@ -112,10 +199,10 @@ namespace jul
     // ---------------------------------------------------------------------------------
     // Wrapper for std::sort for a complete container, returns a copy of the container.
     // ---------------------------------------------------------------------------------
-    template <class Container>
+    template <class Container, class = std::enable_if_t<!is_execution_policy_v<Container>>>
     Container sorted(Container c)
     {
-        std::sort(std::execution::par, std::begin(c), std::end(c));
+        jul::sort(c);
         return c;
     }
 
@@ -124,13 +211,268 @@ namespace jul
     // ---------------------------------------------------------------------------------
     // Wrapper for std::sort for a complete container, returns a copy and uses a custom predicate.
     // ---------------------------------------------------------------------------------
-    template <class Container, class Predicate>
+    template <class Container, class Predicate, class = std::enable_if_t<!is_execution_policy_v<Container>>>
     Container sorted(Container c, Predicate&& pred)
     {
-        std::sort(std::execution::par, std::begin(c), std::end(c), pred);
+        jul::sort(c, pred);
         return c;
     }
-    
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Wrapper for std::sort with an explicit execution policy, returns a copy of the container.
+    // ---------------------------------------------------------------------------------
+    template <class Policy, class Container, class Predicate = std::less<>, class = std::enable_if_t<is_execution_policy_v<Policy>>>
+    Container sorted(Policy&& policy, Container c, Predicate&& pred = {})
+    {
+        std::sort(policy, std::begin(c), std::end(c), pred);
+        return c;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Get the k 'best' elements of a container in sorted order without sorting
+    // the whole container. The default predicate selects the k largest values.
+    // Every thread selects the top k of its own chunk, those candidates are merged
+    // afterwards. Only k * chunks elements are ever copied.
+    // Example:
+    // auto best = top_k(std::vector<int>{ 5, 1, 9, 3, 7 }, 3);
+    // => best = { 9, 7, 5 }
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Predicate = std::greater<>>
+    auto top_k(const Container& c, std::size_t k, Predicate&& pred = {})
+    {
+        using T = typename Container::value_type;
+
+        const std::size_t size = std::size(c);
+        k = std::min(k, size);
+
+        // not worth the threads: one sequential selection
+        const std::size_t chunks = std::min<std::size_t>(hardware_threads(), size / (k + 1) / 1024 + 1);
+        if (chunks <= 1) {
+            std::vector<T> result(k);
+            std::partial_sort_copy(std::begin(c), std::end(c), std::begin(result), std::end(result), pred);
+            return result;
+        }
+
+        std::vector<T> candidates(chunks * k);
+        std::vector<std::size_t> chunk_index(chunks);
+        std::iota(std::begin(chunk_index), std::end(chunk_index), std::size_t{ 0 });
+
+        std::for_each(std::execution::par, std::begin(chunk_index), std::end(chunk_index), [&](std::size_t n) {
+            const auto first = std::next(std::begin(c), size * n / chunks);
+            const auto last  = std::next(std::begin(c), size * (n + 1) / chunks);
+            const auto out   = std::next(std::begin(candidates), k * n);
+            std::partial_sort_copy(first, last, out, std::next(out, k), pred);
+        });
+
+        // every chunk has at least k elements, so the candidates are complete
+        std::partial_sort(std::begin(candidates), std::next(std::begin(candidates), k), std::end(candidates), pred);
+        candidates.resize(k);
+        return candidates;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Wrapper for std::partial_sort, returns a copy of the container where the first
+    // k elements are sorted. The order of the remaining elements is unspecified.
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Predicate = std::less<>>
+    Container partial_sorted(Container c, std::size_t k, Predicate&& pred = {})
+    {
+        const auto middle = std::next(std::begin(c), std::min<std::size_t>(k, std::size(c)));
+        with_policy(std::size(c), [&](auto policy) {
+            std::partial_sort(policy, std::begin(c), middle, std::end(c), pred);
+        });
+        return c;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Get the element that would be at index n if the container was sorted.
+    // Wrapper for std::nth_element, works on a copy of the container.
+    // Precondition: n < size of the container!
+    // Example:
+    // auto median = nth(std::vector<int>{ 5, 1, 9, 3, 7 }, 2);
+    // => median = 5
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Predicate = std::less<>>
+    auto nth(Container c, std::size_t n, Predicate&& pred = {})
+    {
+        assert(n < std::size(c) && "Index is out of range!");
+
+        const auto target = std::next(std::begin(c), n);
+        with_policy(std::size(c), [&](auto policy) {
+            std::nth_element(policy, std::begin(c), target, std::end(c), pred);
+        });
+        return *target;
+    }
+
+
+
+    namespace detail {
+
+        // Keys that fit into 64 bits are radix sorted, wider ones (e.g. an 80 bit
+        // long double, stored in 16 bytes with padding) use the comparison sort.
+        template <class T>
+        inline constexpr bool has_radix_key_v = std::is_arithmetic<T>::value && sizeof(T) <= sizeof(std::uint64_t);
+
+        // Maps an arithmetic key onto an unsigned integer with the same ordering.
+        template <class T>
+        auto radix_key(T value)
+        {
+            static_assert(std::is_arithmetic<T>::value, "Radix keys need an arithmetic type!");
+
+            using Bits = std::conditional_t<sizeof(T) == 1, std::uint8_t,
+                         std::conditional_t<sizeof(T) == 2, std::uint16_t,
+                         std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>>>;
+            static_assert(sizeof(Bits) == sizeof(T), "Unsupported key size!");
+
+            constexpr Bits sign_bit = Bits{ 1 } << (sizeof(T) * 8 - 1);
+
+            Bits bits;
+            std::memcpy(&bits, &value, sizeof(T));
+
+            if constexpr (std::is_floating_point<T>::value) {
+                return static_cast<Bits>((bits & sign_bit) ? ~bits : (bits | sign_bit));
+            }
+            else if constexpr (std::is_signed<T>::value) {
+                return static_cast<Bits>(bits ^ sign_bit);
+            }
+            else {
+                return bits;
+            }
+        }
+
+        // Stable LSD radix sort of (key, index) pairs, 8 bits per pass.
+        // Passes where every key has the same digit are skipped.
+        template <class Bits>
+        void radix_sort_keys(std::vector<std::pair<Bits, std::size_t>>& keys)
+        {
+            constexpr std::size_t passes = sizeof(Bits);
+
+            std::size_t histogram[passes][256] = {};
+            for (const auto& [key, index] : keys) {
+                for (std::size_t pass = 0; pass < passes; ++pass) {
+                    histogram[pass][(key >> (pass * 8)) & 0xFF]++;
+                }
+            }
+
+            std::vector<std::pair<Bits, std::size_t>> buffer(std::size(keys));
+            for (std::size_t pass = 0; pass < passes; ++pass) {
+                auto& counts = histogram[pass];
+                if (std::find(std::begin(counts), std::end(counts), std::size(keys)) != std::end(counts)) {
+                    continue;
+                }
+
+                std::size_t offset = 0;
+                for (auto& count : counts) {
+                    offset += std::exchange(count, offset);
+                }
+                for (const auto& key : keys) {
+                    buffer[counts[(key.first >> (pass * 8)) & 0xFF]++] = key;
+                }
+                keys.swap(buffer);
+            }
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Get the permutation that would sort the container by a projected key, without
+    // moving any of the elements. Only compact (key, index) pairs are sorted: radix sort
+    // for arithmetic keys up to 64 bits, a parallel std::sort otherwise. The order is stable.
+    // Example:
+    // std::vector<Record> records = ...;
+    // auto order = argsort_by(records, [](const Record& r) { return r.score; });
+    // => records[order[0]] has the lowest score
+    // ---------------------------------------------------------------------------------
+    template <class Container, class Projection>
+    std::vector<std::size_t> argsort_by(const Container& c, Projection&& key_of)
+    {
+        using Key = std::decay_t<decltype(key_of(*std::begin(c)))>;
+
+        std::vector<std::size_t> order;
+        order.reserve(std::size(c));
+
+        if constexpr (detail::has_radix_key_v<Key>) {
+            using Bits = decltype(detail::radix_key(Key{}));
+
+            std::vector<std::pair<Bits, std::size_t>> keys;
+            keys.reserve(std::size(c));
+            for (const auto& value : c) {
+                keys.emplace_back(detail::radix_key(key_of(value)), std::size(keys));
+            }
+
+            detail::radix_sort_keys(keys);
+            for (const auto& key : keys) {
+                order.push_back(key.second);
+            }
+        }
+        else {
+            std::vector<std::pair<Key, std::size_t>> keys;
+            keys.reserve(std::size(c));
+            for (const auto& value : c) {
+                keys.emplace_back(key_of(value), std::size(keys));
+            }
+
+            jul::sort(keys);
+            for (const auto& key : keys) {
+                order.push_back(key.second);
+            }
+        }
+
+        return order;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Get the permutation that would sort the container, the elements are the keys.
+    // Example:
+    // auto order = argsort(std::vector<int>{ 30, 10, 20 });
+    // => order = { 1, 2, 0 }
+    // ---------------------------------------------------------------------------------
+    template <class Container>
+    std::vector<std::size_t> argsort(const Container& c)
+    {
+        return argsort_by(c, [](const auto& value) -> const auto& { return value; });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Reorder one or many parallel arrays with a permutation (see argsort):
+    // afterwards a[n] holds the old a[order[n]]. Every array is gathered into one
+    // sequentially written buffer and moved back, so all arrays share one sort.
+    // Example:
+    // auto order = argsort(ids);
+    // apply_permutation(order, ids, names, scores);
+    // ---------------------------------------------------------------------------------
+    template <class... ArrayLikes>
+    void apply_permutation(const std::vector<std::size_t>& order, ArrayLikes&... arrays)
+    {
+        auto gather = [&](auto& array) {
+            assert(std::size(array) == std::size(order) && "Permutation doesn't match the container!");
+
+            // not decltype(array[0]): that's the bit proxy of a std::vector<bool>
+            using T = typename std::iterator_traits<decltype(std::begin(array))>::value_type;
+            std::vector<T> buffer;
+            buffer.reserve(std::size(order));
+            for (const auto index : order) {
+                buffer.push_back(std::move(array[index]));
+            }
+            std::move(std::begin(buffer), std::end(buffer), std::begin(array));
+        };
+
+        (gather(arrays), ...);
+    }
+
 
 
     // ---------------------------------
@@ -1,8 +1,6 @@
 #ifndef JUL_SPIN_LOCK_H
 #define JUL_SPIN_LOCK_H
 
-#include <atomic>
-
 /*
 MIT License
 Copyright(c) 2019 Julian Steigerwald
@@ -23,14 +21,24 @@ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
 SOFTWARE.
 */
 
+#include <atomic>
+#include <utility>
+
+#include "Parallel.h"
+
 namespace jul {
 
 
 	// -----------------------------------------------------------------------------------------
-	// A simple spin lock implementation based on std::atomic_flag.
+	// A spin lock for short critical sections.
 	// General: Spin locks performane better than mutexes when the locking period is "short".
 	// Please do some actual performance profiling before using this class over a std::mutex!
 	//
+	// lock() is a test-and-test-and-set loop: waiting threads only read the lock (no cache
+	// line ping-pong from RMW operations) and back off exponentially with cpu_relax().
+	// After the spin budget (Backoff::Spin_Limit) a waiter sleeps in std::atomic::wait
+	// (futex) if the library supports it (C++20), otherwise it yields.
+	//
 	// Ref: https://en.cppreference.com/w/cpp/atomic/atomic_flag
 	// -----------------------------------------------------------------------------------------
 	class Spin_Lock final {
@@ -41,19 +49,60 @@ namespace jul {
 		
 		void lock()
 		{
-			while (m_flag.test_and_set(std::memory_order_acquire))
-			{
-				/* spin and do nothing */
+			if (!try_acquire()) {
+				lock_contended();
 			}
 		}
 
+		bool try_lock()
+		{
+			return m_state.load(std::memory_order_relaxed) == Unlocked && try_acquire();
+		}
+
 		void unlock()
 		{
-			m_flag.clear(std::memory_order_release);
+#if defined(__cpp_lib_atomic_wait)
+			if (m_state.exchange(Unlocked, std::memory_order_release) == Sleeping) {
+				m_state.notify_one();
+			}
+#else
+			m_state.store(Unlocked, std::memory_order_release);
+#endif
 		}
 
 	private:
-		std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+		// Sleeping: locked and there may be threads in wait(), unlock has to wake one
+		enum State : int { Unlocked = 0, Locked = 1, Sleeping = 2 };
+
+		std::atomic<int> m_state = { Unlocked };
+
+		bool try_acquire()
+		{
+			int expected = Unlocked;
+			return m_state.compare_exchange_strong(expected, Locked, std::memory_order_acquire, std::memory_order_relaxed);
+		}
+
+		void lock_contended()
+		{
+			Backoff backoff;
+			while (backoff.is_spinning()) {
+				if (m_state.load(std::memory_order_relaxed) == Unlocked && try_acquire()) return;
+				backoff.pause();
+			}
+
+#if defined(__cpp_lib_atomic_wait)
+			// A thread that slept takes the lock as Sleeping, so the next unlock wakes
+			// the other sleepers too (no lost wake ups).
+			while (m_state.exchange(Sleeping, std::memory_order_acquire) != Unlocked) {
+				m_state.wait(Sleeping, std::memory_order_relaxed);
+			}
+#else
+			for (;;) {
+				if (m_state.load(std::memory_order_relaxed) == Unlocked && try_acquire()) return;
+				backoff.pause(); // yields
+			}
+#endif
+		}
 
 
 		// no copies or moves!
@@ -63,6 +112,193 @@ namespace jul {
 		Spin_Lock& operator=(Spin_Lock&& other) = delete;
 	};
 
+
+
+	// -----------------------------------------------------------------------------------------
+	// A fair spin lock: threads get the lock in the order they called lock() (FIFO).
+	// lock() draws a ticket and waits until it is served, unlock() serves the next ticket.
+	// No thread can starve, but every waiter spins on the same cache line and a preempted
+	// waiter blocks everyone behind it. Use Mcs_Lock for many waiting cores.
+	//
+	// Example:
+	// Ticket_Lock lock;
+	// std::lock_guard<Ticket_Lock> guard(lock);
+	// -----------------------------------------------------------------------------------------
+	class Ticket_Lock final {
+	public:
+
+		Ticket_Lock()  = default;
+		~Ticket_Lock() = default;
+
+		void lock()
+		{
+			const unsigned ticket = m_next.fetch_add(1, std::memory_order_relaxed);
+			Backoff backoff;
+			while (m_serving.load(std::memory_order_acquire) != ticket) {
+				backoff.pause();
+			}
+		}
+
+		// only succeeds if nobody holds or waits for the lock
+		bool try_lock()
+		{
+			unsigned ticket = m_serving.load(std::memory_order_relaxed);
+			return m_next.compare_exchange_strong(ticket, ticket + 1, std::memory_order_acquire, std::memory_order_relaxed);
+		}
+
+		void unlock()
+		{
+			// only the owner writes m_serving
+			m_serving.store(m_serving.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+		}
+
+	private:
+		alignas(cache_line_size) std::atomic<unsigned> m_next    = { 0 };
+		alignas(cache_line_size) std::atomic<unsigned> m_serving = { 0 };
+
+		// no copies or moves!
+		Ticket_Lock(Ticket_Lock&& other)                 = delete;
+		Ticket_Lock& operator=(const Ticket_Lock& other) = delete;
+		Ticket_Lock(const Ticket_Lock& other)       = delete;
+		Ticket_Lock& operator=(Ticket_Lock&& other) = delete;
+	};
+
+
+
+	namespace detail {
+
+		// queue entry of a Mcs_Lock waiter, one cache line each
+		struct alignas(cache_line_size) Mcs_Node {
+			std::atomic<Mcs_Node*> next   = { nullptr };
+			std::atomic<bool>      locked = { false };
+			Mcs_Node*              free   = nullptr; // free list link
+		};
+
+		// Nodes of the current thread. A thread can hold several Mcs_Locks at once,
+		// so there is a list instead of one node. Nodes are reused, not freed, until
+		// the thread exits.
+		class Mcs_Node_Pool {
+		public:
+			Mcs_Node_Pool() = default;
+			Mcs_Node_Pool(const Mcs_Node_Pool&) = delete;
+			Mcs_Node_Pool& operator=(const Mcs_Node_Pool&) = delete;
+
+			~Mcs_Node_Pool()
+			{
+				while (m_free) {
+					delete std::exchange(m_free, m_free->free);
+				}
+			}
+
+			Mcs_Node* acquire()
+			{
+				if (!m_free) return new Mcs_Node;
+				return std::exchange(m_free, m_free->free);
+			}
+
+			void release(Mcs_Node* node)
+			{
+				node->free = m_free;
+				m_free = node;
+			}
+
+			static Mcs_Node_Pool& local()
+			{
+				thread_local Mcs_Node_Pool pool;
+				return pool;
+			}
+
+		private:
+			Mcs_Node* m_free = nullptr;
+		};
+	}
+
+
+
+	// -----------------------------------------------------------------------------------------
+	// A fair queue lock (Mellor-Crummey and Scott): waiters form a linked queue and every
+	// waiter spins on the flag of its own node (own cache line). unlock() hands the lock to
+	// the next node with one store, so contention does not grow with the number of cores.
+	// Slower than Spin_Lock/Ticket_Lock when uncontended (one more atomic operation).
+	// The nodes come from a thread local free list, lock() and unlock() have to be called
+	// by the same thread.
+	//
+	// Example:
+	// Mcs_Lock lock;
+	// std::lock_guard<Mcs_Lock> guard(lock);
+	// -----------------------------------------------------------------------------------------
+	class Mcs_Lock final {
+	public:
+
+		Mcs_Lock()  = default;
+		~Mcs_Lock() = default;
+
+		void lock()
+		{
+			detail::Mcs_Node* node = detail::Mcs_Node_Pool::local().acquire();
+			node->next.store(nullptr, std::memory_order_relaxed);
+			node->locked.store(true, std::memory_order_relaxed);
+
+			detail::Mcs_Node* previous = m_tail.exchange(node, std::memory_order_acq_rel);
+			if (previous) {
+				previous->next.store(node, std::memory_order_release);
+				Backoff backoff;
+				while (node->locked.load(std::memory_order_acquire)) {
+					backoff.pause();
+				}
+			}
+			m_owner = node;
+		}
+
+		// only succeeds if nobody holds or waits for the lock
+		bool try_lock()
+		{
+			if (m_tail.load(std::memory_order_relaxed)) return false;
+
+			detail::Mcs_Node* node = detail::Mcs_Node_Pool::local().acquire();
+			node->next.store(nullptr, std::memory_order_relaxed);
+
+			detail::Mcs_Node* expected = nullptr;
+			if (!m_tail.compare_exchange_strong(expected, node, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+				detail::Mcs_Node_Pool::local().release(node);
+				return false;
+			}
+			m_owner = node;
+			return true;
+		}
+
+		void unlock()
+		{
+			detail::Mcs_Node* node = m_owner;
+			detail::Mcs_Node* next = node->next.load(std::memory_order_acquire);
+			if (!next) {
+				// no successor: try to empty the queue
+				detail::Mcs_Node* expected = node;
+				if (m_tail.compare_exchange_strong(expected, nullptr, std::memory_order_release, std::memory_order_relaxed)) {
+					detail::Mcs_Node_Pool::local().release(node);
+					return;
+				}
+				// a successor swapped itself in but has not linked yet
+				Backoff backoff;
+				while (!(next = node->next.load(std::memory_order_acquire))) {
+					backoff.pause();
+				}
+			}
+			next->locked.store(false, std::memory_order_release);
+			detail::Mcs_Node_Pool::local().release(node);
+		}
+
+	private:
+		alignas(cache_line_size) std::atomic<detail::Mcs_Node*> m_tail = { nullptr };
+		detail::Mcs_Node* m_owner = nullptr; // node of the current owner, only used by the owner
+
+		// no copies or moves!
+		Mcs_Lock(Mcs_Lock&& other)                 = delete;
+		Mcs_Lock& operator=(const Mcs_Lock& other) = delete;
+		Mcs_Lock(const Mcs_Lock& other)       = delete;
+		Mcs_Lock& operator=(Mcs_Lock&& other) = delete;
+	};
+
 }
 
 
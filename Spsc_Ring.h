@@ -0,0 +1,169 @@
+#ifndef JUL_SPSC_RING_H
+#define JUL_SPSC_RING_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+#include "Parallel.h"
+#include "Ring.h"
+
+namespace jul {
+
+    // ---------------------------------------------------------------
+    // Spsc_Ring (class) = lock-free single producer, single consumer
+    // queue on the storage of a jul::Ring.
+    // Exactly one thread may push and exactly one (other) thread may
+    // pop. Nothing is overwritten, a push into a full ring fails.
+    //
+    // Head (consumer) and tail (producer) are free running counters on
+    // their own cache lines, masked with Size - 1 on access. Each side
+    // caches the last index it read from the other side and only
+    // reloads it (a cache miss) when the cached value says full / empty.
+    //
+    // Example:
+    // Spsc_Ring<Sample, 4096> queue;
+    // // capture thread
+    // while (!queue.try_push(sample)) { cpu_relax(); }
+    // // writer thread
+    // Sample batch[256];
+    // auto count = queue.try_pop_n(batch, 256);
+    // ---------------------------------------------------------------
+    template <class T, std::size_t Size>
+    class Spsc_Ring {
+    public:
+
+        static_assert(Size > 0 && (Size & (Size - 1)) == 0, "The size of a Spsc_Ring has to be a power of two!");
+
+        // member types
+        using value_type = T;
+        using size_type  = std::size_t;
+
+        Spsc_Ring() = default;
+
+        Spsc_Ring(const Spsc_Ring&)            = delete;
+        Spsc_Ring& operator=(const Spsc_Ring&) = delete;
+
+        // producer: false if the ring is full
+        bool try_push(const T& value) { return try_emplace(value); }
+        bool try_push(T&& value)      { return try_emplace(std::move(value)); }
+
+        template <class... Args>
+        bool try_emplace(Args&&... args)
+        {
+            const size_type tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cached_head == Size) {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+                if (tail - m_cached_head == Size) return false;
+            }
+
+            m_ring[tail & Mask] = T(std::forward<Args>(args)...);
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // producer: pushes up to count values, returns how many were pushed
+        size_type try_push_n(const T* values, size_type count)
+        {
+            const size_type tail = m_tail.load(std::memory_order_relaxed);
+            if (Size - (tail - m_cached_head) < count) {
+                m_cached_head = m_head.load(std::memory_order_acquire);
+            }
+
+            const size_type pushed = std::min(count, Size - (tail - m_cached_head));
+            // at most two contiguous blocks: up to the end of the storage and from its start
+            const size_type first = tail & Mask;
+            const size_type split = std::min(pushed, Size - first);
+            std::copy(values, values + split, std::begin(m_ring) + first);
+            std::copy(values + split, values + pushed, std::begin(m_ring));
+            m_tail.store(tail + pushed, std::memory_order_release);
+            return pushed;
+        }
+
+        // consumer: false if the ring is empty
+        bool try_pop(T& out)
+        {
+            const size_type head = m_head.load(std::memory_order_relaxed);
+            if (head == m_cached_tail) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+                if (head == m_cached_tail) return false;
+            }
+
+            out = std::move(m_ring[head & Mask]);
+            m_head.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer: pops up to count values into out, returns how many were popped
+        size_type try_pop_n(T* out, size_type count)
+        {
+            const size_type head = m_head.load(std::memory_order_relaxed);
+            if (m_cached_tail - head < count) {
+                m_cached_tail = m_tail.load(std::memory_order_acquire);
+            }
+
+            const size_type popped = std::min(count, m_cached_tail - head);
+            const size_type first = head & Mask;
+            const size_type split = std::min(popped, Size - first);
+            std::move(std::begin(m_ring) + first, std::begin(m_ring) + first + split, out);
+            std::move(std::begin(m_ring), std::begin(m_ring) + (popped - split), out + split);
+            m_head.store(head + popped, std::memory_order_release);
+            return popped;
+        }
+
+        // Only a snapshot while the other thread is running!
+        // Head first: it never passes the tail read after it, so a third
+        // thread can not see head > tail.
+        size_type size_approx() const
+        {
+            const size_type head = m_head.load(std::memory_order_acquire);
+            const size_type tail = m_tail.load(std::memory_order_acquire);
+            return tail - head;
+        }
+
+        bool empty_approx() const { return size_approx() == 0; }
+
+        static constexpr size_type capacity() { return Size; }
+
+    private:
+        static constexpr size_type Mask = Size - 1;
+
+        // consumer line
+        alignas(cache_line_size) std::atomic<size_type> m_head = 0;
+        size_type m_cached_tail = 0;
+
+        // producer line
+        alignas(cache_line_size) std::atomic<size_type> m_tail = 0;
+        size_type m_cached_head = 0;
+
+        alignas(cache_line_size) Ring<T, Size> m_ring;
+    };
+}
+
+#endif // JUL_SPSC_RING_H
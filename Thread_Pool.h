@@ -0,0 +1,573 @@
+#ifndef JUL_THREAD_POOL_H
+#define JUL_THREAD_POOL_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Bit.h"
+#include "Parallel.h"
+
+// After the jul headers and without NOMINMAX (no macros from a library header):
+// the min / max calls below name their type, so the windows.h macros don't match.
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace jul {
+
+    namespace detail {
+
+        // ---------------------------------------------------------------
+        // Chase-Lev work stealing deque (in the C11 formulation of Le, Pop,
+        // Cohen and Zappa Nardelli). The owner thread pushes and takes at
+        // the bottom (LIFO, cache hot), any other thread steals at the top
+        // (FIFO, the oldest and usually biggest work).
+        // Grows when full. Old arrays are kept until the deque dies, a thief
+        // may still read from them.
+        // ---------------------------------------------------------------
+        template <class T>
+        class Chase_Lev_Deque {
+        public:
+            static_assert(std::is_trivially_copyable<T>::value, "Chase_Lev_Deque stores T in atomics!");
+
+            explicit Chase_Lev_Deque(std::size_t capacity = 256)
+            {
+                m_arrays.push_back(std::make_unique<Array>(next_power_of_two(std::max<std::size_t>(capacity, 2))));
+                m_array.store(m_arrays.back().get(), std::memory_order_relaxed);
+            }
+
+            Chase_Lev_Deque(const Chase_Lev_Deque&)            = delete;
+            Chase_Lev_Deque& operator=(const Chase_Lev_Deque&) = delete;
+
+            // owner only
+            void push(T value)
+            {
+                const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+                const std::int64_t top    = m_top.load(std::memory_order_acquire);
+                Array*             array  = m_array.load(std::memory_order_relaxed);
+
+                if (bottom - top >= static_cast<std::int64_t>(array->size())) {
+                    array = grow(array, top, bottom);
+                }
+                array->put(bottom, value);
+                m_bottom.store(bottom + 1, std::memory_order_release);
+            }
+
+            // owner only, false if empty
+            bool take(T& out)
+            {
+                const std::int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+                Array*             array  = m_array.load(std::memory_order_relaxed);
+                m_bottom.store(bottom, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                std::int64_t top = m_top.load(std::memory_order_relaxed);
+
+                if (top > bottom) {
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                out = array->get(bottom);
+                if (top == bottom) {
+                    // the last value, race against the thieves
+                    const bool won = m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+                    m_bottom.store(bottom + 1, std::memory_order_relaxed);
+                    return won;
+                }
+                return true;
+            }
+
+            // any thread, false if empty or another thread was faster
+            bool steal(T& out)
+            {
+                std::int64_t top = m_top.load(std::memory_order_acquire);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                const std::int64_t bottom = m_bottom.load(std::memory_order_acquire);
+                if (top >= bottom) return false;
+
+                Array* array = m_array.load(std::memory_order_acquire);
+                out = array->get(top);
+                return m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+            }
+
+            bool empty_approx() const
+            {
+                return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+            }
+
+        private:
+            class Array {
+            public:
+                explicit Array(std::size_t size) : m_values(size), m_mask{ size - 1 } {}
+
+                std::size_t size() const { return m_mask + 1; }
+
+                T    get(std::int64_t n) const   { return m_values[static_cast<std::size_t>(n) & m_mask].load(std::memory_order_relaxed); }
+                void put(std::int64_t n, T value) { m_values[static_cast<std::size_t>(n) & m_mask].store(value, std::memory_order_relaxed); }
+
+            private:
+                std::vector<std::atomic<T>> m_values;
+                std::size_t                 m_mask;
+            };
+
+            alignas(cache_line_size) std::atomic<std::int64_t> m_top{ 0 };
+            alignas(cache_line_size) std::atomic<std::int64_t> m_bottom{ 0 };
+            std::atomic<Array*>                               m_array{ nullptr };
+            std::vector<std::unique_ptr<Array>>               m_arrays; // owner only
+
+            Array* grow(Array* array, std::int64_t top, std::int64_t bottom)
+            {
+                m_arrays.push_back(std::make_unique<Array>(2 * array->size()));
+                Array* bigger = m_arrays.back().get();
+                for (std::int64_t n = top; n < bottom; ++n) {
+                    bigger->put(n, array->get(n));
+                }
+                m_array.store(bigger, std::memory_order_release);
+                return bigger;
+            }
+        };
+    }
+
+
+
+    // ---------------------------------------------------------------
+    // Where the workers of a Thread_Pool run.
+    // None:  the OS decides (and moves threads around).
+    // Cores: worker n is pinned to CPU (n + 1) % hardware_threads(),
+    //        CPU 0 stays for the thread that created the pool. Keeps
+    //        the caches (and the NUMA node) of a worker warm, but
+    //        pinned workers compete with every other process.
+    // ---------------------------------------------------------------
+    enum class Pinning {
+        None,
+        Cores
+    };
+
+
+
+    // ---------------------------------------------------------------
+    // Pins the calling thread to one CPU, false if that is not
+    // supported or failed.
+    // ---------------------------------------------------------------
+    inline bool pin_current_thread(unsigned cpu)
+    {
+#if defined(_WIN32)
+        if (cpu >= 8 * sizeof(DWORD_PTR)) return false;
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR{ 1 } << cpu) != 0;
+#elif defined(__linux__)
+        if (cpu >= CPU_SETSIZE) return false;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+        (void)cpu;
+        return false;
+#endif
+    }
+
+
+
+    class Task_Group;
+
+    // ---------------------------------------------------------------
+    // Thread_Pool (class) = work stealing thread pool.
+    // Every worker has a Chase-Lev deque: tasks spawned by a worker go
+    // to its own deque and are run LIFO by it, idle workers steal the
+    // oldest tasks of the others. Tasks of other threads go to a shared
+    // queue. Idle workers spin shortly, then sleep until new work comes.
+    //
+    // A thread that waits (Task_Group::wait, parallel_for) runs tasks
+    // itself instead of blocking, so nested parallelism does not
+    // deadlock and the caller counts as one more worker. That is why
+    // default_pool() starts hardware_threads() - 1 workers.
+    //
+    // The pool is a scheduler (see Parallel.h) for all '_on'
+    // algorithms of this library.
+    //
+    // Example:
+    // Thread_Pool pool(8, Pinning::Cores);
+    // pool.parallel_for(0, std::size(v), 1024, [&](std::size_t first, std::size_t last) { ... });
+    // sort_on(default_pool(), values);
+    // ---------------------------------------------------------------
+    class Thread_Pool {
+    public:
+
+        explicit Thread_Pool(unsigned threads = std::max<unsigned>(1U, hardware_threads() - 1), Pinning pinning = Pinning::None) :
+            m_pinning{ pinning }
+        {
+            m_workers.reserve(threads);
+            for (unsigned n = 0; n < threads; ++n) {
+                m_workers.push_back(std::make_unique<Worker>());
+            }
+            for (unsigned n = 0; n < threads; ++n) {
+                m_workers[n]->thread = std::thread([this, n] { work(n); });
+            }
+        }
+
+        ~Thread_Pool()
+        {
+            m_stopping.store(true, std::memory_order_seq_cst);
+            {
+                std::lock_guard<std::mutex> guard(m_sleep_mutex);
+            }
+            m_wake.notify_all();
+
+            for (auto& worker : m_workers) {
+                worker->thread.join();
+            }
+            // tasks left behind (a Task_Group waits for its tasks, so only unowned ones)
+            for (auto& worker : m_workers) {
+                Task* task = nullptr;
+                while (worker->deque.steal(task)) delete task;
+            }
+            for (Task* task : m_injected) delete task;
+        }
+
+        Thread_Pool(const Thread_Pool&)            = delete;
+        Thread_Pool& operator=(const Thread_Pool&) = delete;
+
+        // Calls fn(chunk_first, chunk_last) for chunks of 'grain' indices of [first, last)
+        // and returns when all are done. The chunks are handed out dynamically (an atomic
+        // counter) to the calling thread and up to thread_count() workers.
+        template <class Function>
+        void parallel_for(std::size_t first, std::size_t last, std::size_t grain, Function&& fn);
+
+        unsigned thread_count() const { return static_cast<unsigned>(std::size(m_workers)); }
+
+        // true if the calling thread is a worker of this pool
+        bool is_worker() const { return current_worker() != No_Worker; }
+
+    private:
+        friend class Task_Group;
+
+        struct Task {
+            std::function<void()> fn;
+            Task_Group*           group;
+        };
+
+        struct alignas(cache_line_size) Worker {
+            detail::Chase_Lev_Deque<Task*> deque;
+            std::thread                    thread;
+        };
+
+        static constexpr std::size_t No_Worker = static_cast<std::size_t>(-1);
+
+        std::vector<std::unique_ptr<Worker>> m_workers;
+        const Pinning                        m_pinning;
+
+        // tasks of threads outside of the pool
+        std::mutex               m_injected_mutex;
+        std::deque<Task*>        m_injected;
+        std::atomic<std::size_t> m_injected_count{ 0 };
+
+        // sleeping workers
+        alignas(cache_line_size) std::atomic<std::uint64_t> m_epoch{ 0 }; // +1 for every new task
+        std::atomic<unsigned>   m_sleeping{ 0 };
+        std::atomic<bool>       m_stopping{ false };
+        std::mutex              m_sleep_mutex;
+        std::condition_variable m_wake;
+
+        // worker index of the calling thread in this pool
+        std::size_t current_worker() const
+        {
+            const auto& local = local_worker();
+            return local.first == this ? local.second : No_Worker;
+        }
+
+        static std::pair<const Thread_Pool*, std::size_t>& local_worker()
+        {
+            thread_local std::pair<const Thread_Pool*, std::size_t> worker{ nullptr, No_Worker };
+            return worker;
+        }
+
+        void submit(Task* task)
+        {
+            const std::size_t worker = current_worker();
+            if (worker != No_Worker) {
+                m_workers[worker]->deque.push(task);
+            }
+            else {
+                std::lock_guard<std::mutex> guard(m_injected_mutex);
+                m_injected.push_back(task);
+                m_injected_count.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Both sides are seq_cst: either a worker that goes to sleep sees the new
+            // epoch, or it is counted as sleeping here and woken.
+            m_epoch.fetch_add(1, std::memory_order_seq_cst);
+            if (m_sleeping.load(std::memory_order_seq_cst) != 0) {
+                {
+                    std::lock_guard<std::mutex> guard(m_sleep_mutex);
+                }
+                m_wake.notify_one();
+            }
+        }
+
+        // own deque first, then the shared queue, then steal from a random worker on
+        Task* find_task(std::size_t worker)
+        {
+            Task* task = nullptr;
+            if (worker != No_Worker && m_workers[worker]->deque.take(task)) return task;
+
+            if (m_injected_count.load(std::memory_order_relaxed) != 0) {
+                std::lock_guard<std::mutex> guard(m_injected_mutex);
+                if (!m_injected.empty()) {
+                    task = m_injected.front();
+                    m_injected.pop_front();
+                    m_injected_count.fetch_sub(1, std::memory_order_relaxed);
+                    return task;
+                }
+            }
+
+            const std::size_t count = std::size(m_workers);
+            const std::size_t start = count ? random_index() % count : 0;
+            for (std::size_t n = 0; n < count; ++n) {
+                const std::size_t victim = (start + n) % count;
+                if (victim != worker && m_workers[victim]->deque.steal(task)) return task;
+            }
+            return nullptr;
+        }
+
+        // runs one task of the pool if there is one (used by waiting threads)
+        bool try_run_one()
+        {
+            Task* task = find_task(current_worker());
+            if (!task) return false;
+            run(task);
+            return true;
+        }
+
+        inline void run(Task* task);
+
+        void work(std::size_t index)
+        {
+            local_worker() = { this, index };
+            if (m_pinning == Pinning::Cores) {
+                pin_current_thread(static_cast<unsigned>((index + 1) % hardware_threads()));
+            }
+
+            Backoff backoff;
+            for (;;) {
+                const std::uint64_t epoch = m_epoch.load(std::memory_order_seq_cst);
+                if (Task* task = find_task(index)) {
+                    run(task);
+                    backoff.reset();
+                    continue;
+                }
+                if (m_stopping.load(std::memory_order_acquire)) return;
+
+                if (backoff.is_spinning()) {
+                    backoff.pause();
+                    continue;
+                }
+                sleep(epoch);
+                backoff.reset();
+            }
+        }
+
+        // sleeps until a task was submitted after 'epoch' was read (or the pool stops)
+        void sleep(std::uint64_t epoch)
+        {
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_sleeping.fetch_add(1, std::memory_order_seq_cst);
+            m_wake.wait(lock, [&] {
+                return m_epoch.load(std::memory_order_seq_cst) != epoch || m_stopping.load(std::memory_order_acquire);
+            });
+            m_sleeping.fetch_sub(1, std::memory_order_relaxed);
+        }
+
+        static std::size_t random_index()
+        {
+            // xorshift, good enough to spread the thieves
+            thread_local std::uint32_t state = static_cast<std::uint32_t>(thread_index()) * 2654435761U + 1U;
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            return state;
+        }
+    };
+
+
+
+    // ---------------------------------------------------------------
+    // Task_Group (class) = tasks that are waited for together.
+    // run() hands a task to the pool, wait() runs tasks of the pool
+    // until all tasks of the group are done. The first exception of
+    // a task is rethrown by wait(), the other tasks still run.
+    // The destructor waits too (without rethrowing).
+    //
+    // Example:
+    // Task_Group group;            // on default_pool()
+    // group.run([&] { left  = build(tree.left);  });
+    // group.run([&] { right = build(tree.right); });
+    // group.wait();
+    // ---------------------------------------------------------------
+    class Task_Group {
+    public:
+
+        Task_Group();
+        explicit Task_Group(Thread_Pool& pool) : m_pool{ pool } {}
+
+        ~Task_Group()
+        {
+            wait_for_tasks();
+        }
+
+        Task_Group(const Task_Group&)            = delete;
+        Task_Group& operator=(const Task_Group&) = delete;
+
+        template <class Function>
+        void run(Function&& fn)
+        {
+            m_pending.fetch_add(1, std::memory_order_relaxed);
+            m_pool.submit(new Thread_Pool::Task{ std::forward<Function>(fn), this });
+        }
+
+        void wait()
+        {
+            wait_for_tasks();
+
+            if (m_exception) {
+                std::rethrow_exception(std::exchange(m_exception, nullptr));
+            }
+        }
+
+    private:
+        friend class Thread_Pool;
+
+        Thread_Pool&             m_pool;
+        std::atomic<std::size_t> m_pending{ 0 };
+        std::atomic<bool>        m_failed{ false };
+        std::exception_ptr       m_exception;
+
+        void wait_for_tasks()
+        {
+            Backoff backoff;
+            while (m_pending.load(std::memory_order_acquire) != 0) {
+                if (m_pool.try_run_one()) {
+                    backoff.reset();
+                }
+                else {
+                    backoff.pause();
+                }
+            }
+        }
+
+        void finish(std::exception_ptr exception)
+        {
+            // only the first exception is kept, the flag orders the writers
+            if (exception && !m_failed.exchange(true, std::memory_order_relaxed)) {
+                m_exception = std::move(exception);
+            }
+            // the last access: the waiting thread may destroy the group right after it
+            m_pending.fetch_sub(1, std::memory_order_release);
+        }
+    };
+
+
+
+    inline void Thread_Pool::run(Task* task)
+    {
+        std::exception_ptr exception;
+        try {
+            task->fn();
+        }
+        catch (...) {
+            exception = std::current_exception();
+        }
+        Task_Group* group = task->group;
+        delete task;
+        group->finish(std::move(exception));
+    }
+
+
+
+    template <class Function>
+    void Thread_Pool::parallel_for(std::size_t first, std::size_t last, std::size_t grain, Function&& fn)
+    {
+        if (first >= last) return;
+
+        grain = std::max<std::size_t>(grain, 1);
+        const std::size_t chunks = (last - first + grain - 1) / grain;
+        if (chunks == 1 || m_workers.empty()) {
+            fn(first, last);
+            return;
+        }
+
+        std::atomic<std::size_t> next_chunk{ 0 };
+        auto run_chunks = [&] {
+            for (std::size_t n = next_chunk.fetch_add(1, std::memory_order_relaxed); n < chunks; n = next_chunk.fetch_add(1, std::memory_order_relaxed)) {
+                const std::size_t chunk_first = first + n * grain;
+                fn(chunk_first, std::min<std::size_t>(chunk_first + grain, last));
+            }
+        };
+
+        Task_Group group(*this);
+        const std::size_t helpers = std::min<std::size_t>(chunks - 1, std::size(m_workers));
+        for (std::size_t n = 0; n < helpers; ++n) {
+            group.run(run_chunks);
+        }
+        run_chunks();
+        group.wait();
+    }
+
+
+
+    // ---------------------------------------------------------------
+    // The pool shared by the whole program (hardware_threads() - 1
+    // workers, started on first use). Use it instead of creating
+    // pools, several pools oversubscribe the cores.
+    // ---------------------------------------------------------------
+    inline Thread_Pool& default_pool()
+    {
+        static Thread_Pool pool;
+        return pool;
+    }
+
+
+
+    inline Task_Group::Task_Group() : m_pool{ default_pool() } {}
+}
+
+#endif // JUL_THREAD_POOL_H
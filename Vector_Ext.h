@@ -29,13 +29,105 @@ SOFTWARE.
 #include <vector>
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <numeric>
+#include <type_traits>
+#include <execution>
+#include <iterator>
+#include <cstring>
+#include <initializer_list>
+
+#include "Parallel.h"
+#include "Simd.h"
 
 
 namespace jul 
 {
+    // ---------------------------------------------------------------------------------
+    // Containers accepted by the functions of this header: contiguous, resizable
+    // containers with the interface of std::vector. Specialize it for own containers
+    // (see Small_Vector.h).
+    // ---------------------------------------------------------------------------------
+    template <class Container>
+    struct is_vector_like : std::false_type {};
+
+    template <class T, class Allocator>
+    struct is_vector_like<std::vector<T, Allocator>> : std::true_type {};
+
+    template <class Container>
+    inline constexpr bool is_vector_like_v = is_vector_like<std::decay_t<Container>>::value;
+
+    // value type of a vector like container, SFINAE for all other types
+    template <class Vector>
+    using vector_value_t = std::enable_if_t<is_vector_like_v<Vector>, typename std::decay_t<Vector>::value_type>;
+
+
+
+    namespace detail {
+
+        // start offset of every sub vector in the flattened vector, plus the total at the end
+        template <class Outer>
+        std::vector<std::size_t> flatten_offsets(const Outer& v)
+        {
+            std::vector<std::size_t> offsets(std::size(v) + 1, 0);
+            for (std::size_t n = 0; n < std::size(v); ++n) {
+                offsets[n + 1] = offsets[n] + std::size(v[n]);
+            }
+            return offsets;
+        }
+
+        // copies (or moves) all sub vectors into one buffer that is allocated once,
+        // large inputs copy the sub vectors in parallel.
+        // std::vector<bool> packs several values into one word, parallel copies of
+        // different sub vectors would race on it: bool is always copied sequentially.
+        template <bool Move, class Outer>
+        auto flatten_into_buffer(Outer& v)
+        {
+            using T = typename std::decay_t<Outer>::value_type::value_type;
+
+            const auto        offsets = flatten_offsets(v);
+            const std::size_t total   = offsets.back();
+
+            std::vector<T> result;
+            if constexpr (std::is_default_constructible<T>::value && !std::is_same<T, bool>::value) {
+                result.resize(total);
+
+                auto copy_sub = [&](std::size_t n) {
+                    auto out = std::begin(result) + offsets[n];
+                    if constexpr (Move) {
+                        std::move(std::begin(v[n]), std::end(v[n]), out);
+                    }
+                    else {
+                        std::copy(std::begin(v[n]), std::end(v[n]), out);
+                    }
+                };
+
+                std::vector<std::size_t> sub_index(std::size(v));
+                std::iota(std::begin(sub_index), std::end(sub_index), std::size_t{ 0 });
+                with_policy(total, [&](auto policy) {
+                    std::for_each(policy, std::begin(sub_index), std::end(sub_index), copy_sub);
+                });
+            }
+            else {
+                result.reserve(total);
+                for (auto& sub : v) {
+                    if constexpr (Move) {
+                        result.insert(std::end(result), std::make_move_iterator(std::begin(sub)), std::make_move_iterator(std::end(sub)));
+                    }
+                    else {
+                        result.insert(std::end(result), std::begin(sub), std::end(sub));
+                    }
+                }
+            }
+            return result;
+        }
+    }
+
+
+
     // ---------------------------------------------------------------------------------
 	// Flatten a vector of vectors.
+	// The result is allocated once, large inputs are copied in parallel.
 	// Example:
 	// std::vector<int> a{ 1,2,3 }, b{ 4,5,6 };
 	// std::vector<std::vector<int>> vec_vec { a, b };
@@ -43,37 +135,498 @@ namespace jul
 	// auto flattened = jul::flatten(vec_vec);
 	// => flattened = { 1, 2, 3, 4, 5, 6 }
 	// ---------------------------------------------------------------------------------
-	template <typename T>
-	std::vector<T> flatten(const std::vector<std::vector<T>>& v) 
+	template <class Outer, class T = vector_value_t<vector_value_t<Outer>>>
+	std::vector<T> flatten(const Outer& v) 
 	{
-		auto total_size = 0U;
-		for (const auto& sub : v) {
-			total_size += sub.size();
-		}
-
-		std::vector<T> result;
-		result.reserve(total_size);
-		for (const auto& sub : v) {
-			result.insert(std::end(result), std::begin(sub), std::end(sub));
-		}
+		return detail::flatten_into_buffer<false>(v);
+	}
+
+
+
+    // ---------------------------------------------------------------------------------
+	// Flatten a vector of vectors by moving the elements, v is empty afterwards.
+	// Example:
+	// auto flattened = jul::flatten(std::move(per_thread_results));
+	// ---------------------------------------------------------------------------------
+	template <class Outer, class T = vector_value_t<vector_value_t<Outer>>, class = std::enable_if_t<!std::is_reference<Outer>::value && !std::is_const<Outer>::value>>
+	std::vector<T> flatten(Outer&& v)
+	{
+		auto result = detail::flatten_into_buffer<true>(v);
+		v.clear();
 		return result;
 	}
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Jagged_View (class): a flat, read only view of a vector of vectors (no copy).
+    // Only the offsets of the sub vectors are stored, the view is invalidated when
+    // the vector of vectors (or one of its sub vectors) changes its size.
+    // Example:
+    // auto view = jagged_view(per_thread_results);
+    // for (const auto& value : view) { ... }       // all values in flattened order
+    // auto tenth = view[10];                       // O(log rows)
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    class Jagged_View {
+    public:
+
+        using value_type      = T;
+        using size_type       = std::size_t;
+        using const_reference = const T&;
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = const T*;
+            using reference         = const T&;
+
+            const_iterator() = default;
+            const_iterator(const std::vector<std::vector<T>>* rows, size_type row, size_type column) :
+                m_rows{ rows }, m_row{ row }, m_column{ column }
+            {
+                skip_empty_rows();
+            }
+
+            reference operator*()  const { return (*m_rows)[m_row][m_column]; }
+            pointer   operator->() const { return &(*m_rows)[m_row][m_column]; }
+
+            const_iterator& operator++()
+            {
+                ++m_column;
+                skip_empty_rows();
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                auto copy = *this;
+                ++(*this);
+                return copy;
+            }
+
+            bool operator==(const const_iterator& other) const { return m_row == other.m_row && m_column == other.m_column; }
+            bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+        private:
+            const std::vector<std::vector<T>>* m_rows = nullptr;
+            size_type m_row    = 0;
+            size_type m_column = 0;
+
+            void skip_empty_rows()
+            {
+                while (m_row < std::size(*m_rows) && m_column >= std::size((*m_rows)[m_row])) {
+                    ++m_row;
+                    m_column = 0;
+                }
+            }
+        };
+
+        explicit Jagged_View(const std::vector<std::vector<T>>& rows) :
+            m_rows{ &rows },
+            m_offsets{ detail::flatten_offsets(rows) }
+        {}
+
+        // flat index -> value
+        const_reference operator[](size_type index) const
+        {
+            assert(index < size() && "Index is out of range!");
+            const auto row = static_cast<size_type>(std::upper_bound(std::begin(m_offsets), std::end(m_offsets), index) - std::begin(m_offsets)) - 1;
+            return (*m_rows)[row][index - m_offsets[row]];
+        }
+
+        size_type size()  const { return m_offsets.back(); }
+        bool      empty() const { return size() == 0; }
+        size_type rows()  const { return std::size(*m_rows); }
+
+        const std::vector<T>&           row(size_type n) const { return (*m_rows)[n]; }
+        const std::vector<std::size_t>& offsets()        const { return m_offsets; }
+
+        const_iterator begin() const { return { m_rows, 0, 0 }; }
+        const_iterator end()   const { return { m_rows, rows(), 0 }; }
+
+    private:
+        const std::vector<std::vector<T>>* m_rows = nullptr;
+        std::vector<std::size_t>           m_offsets;
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Factory method for a Jagged_View.
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    Jagged_View<T> jagged_view(const std::vector<std::vector<T>>& v)
+    {
+        return Jagged_View<T>{ v };
+    }
     
     
+    namespace detail {
+
+        // Linear search engine: integer and floating point values are compared a
+        // register at a time (simd::Search), the other types use operator==.
+
+        template <class T>
+        inline constexpr bool is_searchable = simd::searchable<simd::search_type_t<T>>;
+
+        template <class T>
+        simd::search_type_t<T> search_bits(const T& value)
+        {
+            simd::search_type_t<T> bits;
+            std::memcpy(&bits, &value, sizeof(T));
+            return bits;
+        }
+
+        // index of the first value == needle, or size
+        template <class T>
+        std::size_t find_index(const T* data, std::size_t size, const T& needle)
+        {
+            std::size_t n = 0;
+
+            if constexpr (is_searchable<T>) {
+                using Lane   = simd::search_type_t<T>;
+                using Search = simd::Search<Lane>;
+                constexpr std::size_t lanes = Search::lanes;
+
+                const Lane* values = reinterpret_cast<const Lane*>(data);
+                const auto  key    = Search::broadcast(search_bits(needle));
+
+                // 4 registers per step, one test for all of them
+                for (; n + 4 * lanes <= size; n += 4 * lanes) {
+                    const simd::Wide_Mask m0 = Search::eq(Search::load(values + n), key);
+                    const simd::Wide_Mask m1 = Search::eq(Search::load(values + n + lanes), key);
+                    const simd::Wide_Mask m2 = Search::eq(Search::load(values + n + 2 * lanes), key);
+                    const simd::Wide_Mask m3 = Search::eq(Search::load(values + n + 3 * lanes), key);
+                    if ((m0 | m1 | m2 | m3) != 0) {
+                        if (m0) return n + simd::first_lane<Lane>(m0);
+                        if (m1) return n + lanes + simd::first_lane<Lane>(m1);
+                        if (m2) return n + 2 * lanes + simd::first_lane<Lane>(m2);
+                        return n + 3 * lanes + simd::first_lane<Lane>(m3);
+                    }
+                }
+                for (; n + lanes <= size; n += lanes) {
+                    const simd::Wide_Mask m = Search::eq(Search::load(values + n), key);
+                    if (m) return n + simd::first_lane<Lane>(m);
+                }
+            }
+
+            for (; n < size; ++n) {
+                if (data[n] == needle) return n;
+            }
+            return size;
+        }
+
+        // Calls on_match(k, count) with the number of values == needles[k] of each
+        // register (or value), stops early when on_match returns true.
+        template <class T, class OnMatch>
+        void match_each(const T* data, std::size_t size, const T* needles, std::size_t needle_count, OnMatch&& on_match)
+        {
+            std::size_t n = 0;
+
+            if constexpr (is_searchable<T>) {
+                using Lane   = simd::search_type_t<T>;
+                using Search = simd::Search<Lane>;
+                constexpr std::size_t lanes = Search::lanes;
+
+                // the first keys stay in registers, more are broadcast on the fly
+                constexpr std::size_t Cached_Keys = 8;
+                typename Search::Register keys[Cached_Keys];
+                for (std::size_t k = 0; k < std::min(needle_count, Cached_Keys); ++k) {
+                    keys[k] = Search::broadcast(search_bits(needles[k]));
+                }
+
+                const Lane* values = reinterpret_cast<const Lane*>(data);
+                for (; n + lanes <= size; n += lanes) {
+                    const auto loaded = Search::load(values + n);
+                    for (std::size_t k = 0; k < needle_count; ++k) {
+                        const auto key = k < Cached_Keys ? keys[k] : Search::broadcast(search_bits(needles[k]));
+                        const simd::Wide_Mask m = Search::eq(loaded, key);
+                        if (m && on_match(k, simd::lane_count<Lane>(m))) return;
+                    }
+                }
+            }
+
+            for (; n < size; ++n) {
+                for (std::size_t k = 0; k < needle_count; ++k) {
+                    if (data[n] == needles[k] && on_match(k, std::size_t{ 1 })) return;
+                }
+            }
+        }
+    }
+
+
+
     // ---------------------------------------------------------------------------------
-    // Does a vector contain a certain value?
+    // Index of the first value == value, or size(v) if there is none (vectorized
+    // like contains).
+    // example:
+    // std::vector<int> ints = { 5,6,7 };
+    // auto index = find_index(ints, 7);
+    //
+    // => index = 2
+    // ---------------------------------------------------------------------------------
+    template <class Vector>
+    std::size_t find_index(const Vector& v, const vector_value_t<Vector>& value)
+    {
+        if constexpr (std::is_same<typename Vector::value_type, bool>::value) {
+            return static_cast<std::size_t>(std::find(std::begin(v), std::end(v), value) - std::begin(v)); // std::vector<bool> has no data()
+        }
+        else {
+            return detail::find_index(std::data(v), std::size(v), value);
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Does a vector contain a certain value? Linear search, vectorized for integers
+    // and floating point values (early exit on the first match). For sorted vectors
+    // use jul::sorted_contains (Search.h) instead.
     // example:
     // std::vector<int> ints = { 0,1,2,3 };
     // bool has_two = contains(ints, 2);
     //
     // => has_two = true
     // ---------------------------------------------------------------------------------
-    template <class T>
-    bool contains(const std::vector<T>& v, const T& value)
+    template <class Vector>
+    bool contains(const Vector& v, const vector_value_t<Vector>& value)
+    {
+        return find_index(v, value) != std::size(v);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Does a vector contain any of the values? One pass over the vector for all
+    // values, meant for a few values (for many use a hash set).
+    // example:
+    // std::vector<int> ints = { 0,1,2,3 };
+    // bool found = contains_any(ints, { 7, 3 });
+    //
+    // => found = true
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class T = vector_value_t<Vector>>
+    bool contains_any(const Vector& v, const std::vector<T>& values)
+    {
+        if constexpr (std::is_same<T, bool>::value) {
+            return std::any_of(std::begin(values), std::end(values), [&](bool value) { return contains(v, value); }); // std::vector<bool> has no data()
+        }
+        else {
+            bool found = false;
+            detail::match_each(std::data(v), std::size(v), std::data(values), std::size(values), [&](std::size_t, std::size_t) {
+                return found = true;
+            });
+            return found;
+        }
+    }
+
+    template <class Vector, class T = vector_value_t<Vector>>
+    bool contains_any(const Vector& v, std::initializer_list<T> values)
+    {
+        return contains_any(v, std::vector<T>(values));
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Number of values == value (vectorized like contains).
+    // example:
+    // std::vector<int> ints = { 0,1,0,3 };
+    // auto zeros = count_equal(ints, 0);
+    //
+    // => zeros = 2
+    // ---------------------------------------------------------------------------------
+    template <class Vector>
+    std::size_t count_equal(const Vector& v, const vector_value_t<Vector>& value)
+    {
+        if constexpr (std::is_same<typename Vector::value_type, bool>::value) {
+            return static_cast<std::size_t>(std::count(std::begin(v), std::end(v), value)); // std::vector<bool> has no data()
+        }
+        else {
+            std::size_t count = 0;
+            detail::match_each(std::data(v), std::size(v), &value, 1, [&](std::size_t, std::size_t matches) {
+                count += matches;
+                return false;
+            });
+            return count;
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Number of values == values[k] for every k, counted in one pass over the vector.
+    // example:
+    // std::vector<int> ints = { 0,1,0,3 };
+    // auto counts = count_equal(ints, { 0, 3, 4 });
+    //
+    // => counts = { 2, 1, 0 }
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class T = vector_value_t<Vector>>
+    std::vector<std::size_t> count_equal(const Vector& v, const std::vector<T>& values)
     {
-        auto first = std::begin(v);
-        auto last = std::end(v);
-        return std::find(first, last, value) != last;
+        std::vector<std::size_t> counts(std::size(values), 0);
+        if constexpr (std::is_same<T, bool>::value) {
+            // std::vector<bool> has no data(), count the true values once
+            const std::size_t trues = count_equal(v, true);
+            for (std::size_t k = 0; k < std::size(values); ++k) {
+                counts[k] = values[k] ? trues : std::size(v) - trues;
+            }
+        }
+        else {
+            detail::match_each(std::data(v), std::size(v), std::data(values), std::size(values), [&](std::size_t k, std::size_t matches) {
+                counts[k] += matches;
+                return false;
+            });
+        }
+        return counts;
+    }
+
+    template <class Vector, class T = vector_value_t<Vector>>
+    std::vector<std::size_t> count_equal(const Vector& v, std::initializer_list<T> values)
+    {
+        return count_equal(v, std::vector<T>(values));
+    }
+
+
+
+    namespace detail {
+
+        // Filters for the stream compaction below. keep(value) is the scalar test,
+        // reject<Pack>(register) the inverse test for all lanes of a simd::Pack.
+        // The scalar tests are written like the original std::remove_if lambdas,
+        // so NaN is handled the same way by both paths.
+        template <class T>
+        struct Not_Equal_Filter {
+            T value;
+
+            bool keep(const T& v) const { return !(v == value); }
+
+            template <class Pack>
+            simd::Mask reject(typename Pack::Register r) const { return Pack::eq(r, Pack::broadcast(value)); }
+        };
+
+        template <class T>
+        struct Within_Filter {
+            T min;
+            T max;
+
+            bool keep(const T& v) const { return !(v < min || v > max); }
+
+            template <class Pack>
+            simd::Mask reject(typename Pack::Register r) const { return Pack::lt(r, Pack::broadcast(min)) | Pack::gt(r, Pack::broadcast(max)); }
+        };
+
+        template <class T>
+        struct Outside_Filter {
+            T min;
+            T max;
+
+            bool keep(const T& v) const { return !(v >= min && v <= max); }
+
+            template <class Pack>
+            simd::Mask reject(typename Pack::Register r) const { return Pack::ge(r, Pack::broadcast(min)) & Pack::le(r, Pack::broadcast(max)); }
+        };
+
+        // types that can be compacted as raw memory
+        template <class T>
+        inline constexpr bool is_compactable = std::is_trivially_copyable<T>::value && !std::is_same<T, bool>::value;
+
+        // Copies the kept values of [first, first + size) to out and returns their number.
+        // Branch free: every value is stored, but out only advances for kept values.
+        // out may be first (in place), otherwise it needs room for 'size' values.
+        template <class T, class Filter>
+        std::size_t compact(const T* first, std::size_t size, T* out, const Filter& filter)
+        {
+            std::size_t n     = 0;
+            std::size_t count = 0;
+
+            if constexpr (simd::available<T>) {
+                using Pack = simd::Pack<T>;
+                for (; n + Pack::lanes <= size; n += Pack::lanes) {
+                    const auto values = Pack::load(first + n);
+                    const auto keep   = ~filter.template reject<Pack>(values) & simd::full_mask<T>();
+                    count += Pack::compress_store(out + count, keep, values);
+                }
+            }
+
+            for (; n < size; ++n) {
+                const T value = first[n];
+                out[count] = value;
+                count += filter.keep(value) ? 1 : 0;
+            }
+            return count;
+        }
+
+        // Same as compact, large inputs are compacted in one chunk per thread
+        // and the chunks are moved together afterwards.
+        template <class T, class Filter>
+        std::size_t parallel_compact(const T* first, std::size_t size, T* out, const Filter& filter)
+        {
+            const std::size_t chunks = hardware_threads();
+            if (size < parallel_threshold || chunks == 1) {
+                return compact(first, size, out, filter);
+            }
+
+            std::vector<std::size_t> counts(chunks);
+            std::vector<std::size_t> chunk_index(chunks);
+            std::iota(std::begin(chunk_index), std::end(chunk_index), std::size_t{ 0 });
+
+            std::for_each(std::execution::par, std::begin(chunk_index), std::end(chunk_index), [&](std::size_t n) {
+                const std::size_t begin = size * n / chunks;
+                const std::size_t end   = size * (n + 1) / chunks;
+                counts[n] = compact(first + begin, end - begin, out + begin, filter);
+            });
+
+            std::size_t total = 0;
+            for (std::size_t n = 0; n < chunks; ++n) {
+                const std::size_t begin = size * n / chunks;
+                if (total != begin) {
+                    std::memmove(out + total, out + begin, counts[n] * sizeof(T));
+                }
+                total += counts[n];
+            }
+            return total;
+        }
+
+        // in place filter of a vector
+        template <class Vector, class Filter>
+        void filter_in_place(Vector& v, const Filter& filter)
+        {
+            using T = typename Vector::value_type;
+
+            if constexpr (is_compactable<T>) {
+                v.resize(parallel_compact(v.data(), std::size(v), v.data(), filter));
+            }
+            else {
+                auto reject = [&](const T& value) { return !filter.keep(value); };
+                v.erase(std::remove_if(std::begin(v), std::end(v), reject), std::end(v));
+            }
+        }
+
+        // filtered copy of a vector
+        template <class Vector, class Filter>
+        Vector filter_copy(const Vector& v, const Filter& filter)
+        {
+            using T = typename Vector::value_type;
+
+            Vector result;
+            if constexpr (is_compactable<T> && simd::available<T>) {
+                // compact needs room for every value, give the memory back if most were dropped
+                result.resize(std::size(v));
+                result.resize(parallel_compact(v.data(), std::size(v), result.data(), filter));
+                if (std::size(result) < std::size(v) / 2) {
+                    result.shrink_to_fit();
+                }
+            }
+            else {
+                std::copy_if(std::begin(v), std::end(v), std::back_inserter(result), [&](const T& value) { return filter.keep(value); });
+            }
+            return result;
+        }
     }
 
 
@@ -86,27 +639,28 @@ namespace jul
     //
     // => ints = {1,3}
     // ---------------------------------------------------------------------------------
-    template <class T>
-    void remove_all(std::vector<T>& v, T value)
+    template <class Vector, class T = vector_value_t<Vector>>
+    void remove_all(Vector& v, vector_value_t<Vector> value)
     {
-        v.erase(std::remove(std::begin(v), std::end(v), value), std::end(v));
+        detail::filter_in_place(v, detail::Not_Equal_Filter<T>{ value });
     }
 
 
 
     // ---------------------------------------------------------------------------------
     // Removes all values from a vector and returns a copy.
+    // For chains of filters and transformations use the lazy views of View.h,
+    // they need no intermediate copies.
     // example:
     // std::vector<int> ints = { 0,1,0,3 };
     // auto without_zero = removed_all(ints, 0);
     //
     // => without_zero = {1,3}
     // ---------------------------------------------------------------------------------
-    template <class T>
-    std::vector<T> removed_all(std::vector<T> v, T value)
+    template <class Vector, class T = vector_value_t<Vector>>
+    Vector removed_all(const Vector& v, vector_value_t<Vector> value)
     {
-        v.erase(std::remove(std::begin(v), std::end(v), value), std::end(v));
-        return v;
+        return detail::filter_copy(v, detail::Not_Equal_Filter<T>{ value });
     }
 
 
@@ -114,23 +668,167 @@ namespace jul
     // ---------------------------------------------------------------------------------
     // Wrapper for std::transform for a complete vector.
     // ---------------------------------------------------------------------------------
-    template <class T, class Function>
-    void apply_each(std::vector<T>& v, Function&& fn)
+    template <class Vector, class Function, class = vector_value_t<Vector>>
+    void apply_each(Vector& v, Function&& fn)
     {
         std::transform(std::begin(v), std::end(v), std::begin(v), fn);
     }
 
 
 
+    // ---------------------------------------------------------------------------------
+    // apply_each on a scheduler (see Parallel.h): v = fn(v) for chunks of 'grain'
+    // elements in parallel. The default grain (0) makes cache sized chunks and runs
+    // small vectors sequentially. Use a small grain for expensive functions.
+    // Example:
+    // Default_Scheduler scheduler;
+    // apply_each_on(scheduler, images, [](Image img) { return blur(img); }, 1);
+    // ---------------------------------------------------------------------------------
+    template <class Scheduler, class Vector, class Function, class T = vector_value_t<Vector>>
+    void apply_each_on(Scheduler& scheduler, Vector& v, Function&& fn, std::size_t grain = 0)
+    {
+        T* data = std::data(v);
+        chunked_for<T>(scheduler, std::size(v), grain, [&](std::size_t first, std::size_t last) {
+            std::transform(data + first, data + last, data + first, fn);
+        });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // apply_each in parallel on the Default_Scheduler.
+    // Example:
+    // parallel_apply_each(values, [](double v) { return std::sqrt(v); });
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class Function, class = vector_value_t<Vector>>
+    void parallel_apply_each(Vector& v, Function&& fn, std::size_t grain = 0)
+    {
+        Default_Scheduler scheduler;
+        apply_each_on(scheduler, v, std::forward<Function>(fn), grain);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Returns fn(value) for every value, computed in chunks on a scheduler. The result
+    // is allocated once, its type has to be default constructible. A bool result is a
+    // std::vector<bool>, computed as chars first (parallel writes into packed bits race).
+    // Example:
+    // auto lengths = transform_on(scheduler, names, [](const std::string& s) { return s.size(); });
+    // ---------------------------------------------------------------------------------
+    template <class Scheduler, class Vector, class Function, class T = vector_value_t<Vector>>
+    auto transform_on(Scheduler& scheduler, const Vector& v, Function&& fn, std::size_t grain = 0)
+    {
+        using Result = std::decay_t<std::invoke_result_t<Function&, const T&>>;
+
+        // Chunks of a std::vector<bool> share words, parallel writes into it would
+        // race: bool results are computed as chars and packed afterwards (one extra pass).
+        using Stored = std::conditional_t<std::is_same<Result, bool>::value, char, Result>;
+
+        std::vector<Stored> result(std::size(v));
+        const auto in  = std::cbegin(v); // no data(): v may be a std::vector<bool> (reading is fine)
+        Stored*    out = result.data();
+        chunked_for<T>(scheduler, std::size(v), grain, [&](std::size_t first, std::size_t last) {
+            std::transform(in + first, in + last, out + first, fn);
+        });
+
+        if constexpr (std::is_same<Result, bool>::value) {
+            return std::vector<bool>(std::begin(result), std::end(result));
+        }
+        else {
+            return result;
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // transform_on the Default_Scheduler.
+    // Example:
+    // auto squares = parallel_transform(values, [](double v) { return v * v; });
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class Function, class = vector_value_t<Vector>>
+    auto parallel_transform(const Vector& v, Function&& fn, std::size_t grain = 0)
+    {
+        Default_Scheduler scheduler;
+        return transform_on(scheduler, v, std::forward<Function>(fn), grain);
+    }
+
+
+
+    namespace detail {
+
+        // The reductions below keep one accumulator per lane, so the compiler can map
+        // the inner loops onto SIMD registers. Sums are always accumulated in double.
+        constexpr std::size_t Reduce_Lanes = 8;
+
+        // Elements per block of stats(), each block is summed relative to its first
+        // element and the blocks are merged with Chan's formula (numerically stable).
+        constexpr std::size_t Stats_Block_Size = 1024;
+
+        // The lane reductions read through data(), std::vector<bool> has none (packed bits),
+        // so bool takes the iterator based std algorithms instead.
+        template <class T>
+        inline constexpr bool is_reducible_v = std::is_arithmetic<T>::value && !std::is_same<T, bool>::value;
+
+        template <class T, class Select>
+        T reduce_lanes(const T* data, std::size_t size, Select&& select)
+        {
+            T lane[Reduce_Lanes];
+            std::fill(std::begin(lane), std::end(lane), data[0]);
+
+            std::size_t n = 0;
+            for (; n + Reduce_Lanes <= size; n += Reduce_Lanes) {
+                for (std::size_t l = 0; l < Reduce_Lanes; ++l) {
+                    lane[l] = select(data[n + l], lane[l]);
+                }
+            }
+            for (; n < size; ++n) {
+                lane[0] = select(data[n], lane[0]);
+            }
+
+            T result = lane[0];
+            for (std::size_t l = 1; l < Reduce_Lanes; ++l) {
+                result = select(lane[l], result);
+            }
+            return result;
+        }
+
+        template <class T>
+        double sum(const T* data, std::size_t size)
+        {
+            double lane[Reduce_Lanes] = {};
+
+            std::size_t n = 0;
+            for (; n + Reduce_Lanes <= size; n += Reduce_Lanes) {
+                for (std::size_t l = 0; l < Reduce_Lanes; ++l) {
+                    lane[l] += static_cast<double>(data[n + l]);
+                }
+            }
+            for (; n < size; ++n) {
+                lane[0] += static_cast<double>(data[n]);
+            }
+
+            return std::accumulate(std::begin(lane), std::end(lane), 0.0);
+        }
+    }
+
+
+
     // ---------------------------------------------------------------------------------
     // Returns the max value of the vector.
     // Precondition: vector can't be empty!
     // ---------------------------------------------------------------------------------
-    template <class T>
-    T max_value(const std::vector<T>& v)
+    template <class Vector, class T = vector_value_t<Vector>>
+    T max_value(const Vector& v)
     {
         assert(std::size(v) != 0);
-        return *std::max_element(std::begin(v), std::end(v));
+        if constexpr (detail::is_reducible_v<T>) {
+            return detail::reduce_lanes(v.data(), std::size(v), [](T a, T b) { return a > b ? a : b; });
+        }
+        else {
+            return *std::max_element(std::begin(v), std::end(v));
+        }
     }
 
 
@@ -139,8 +837,8 @@ namespace jul
     // Returns the max value of the vector with a custom compare function.
     // Precondition: vector can't be empty!
     // ---------------------------------------------------------------------------------
-    template <class T, class Compare>
-    T max_value(const std::vector<T>& v, Compare&& comp)
+    template <class Vector, class Compare, class T = vector_value_t<Vector>>
+    T max_value(const Vector& v, Compare&& comp)
     {
         assert(std::size(v) != 0);
         return *std::max_element(std::begin(v), std::end(v), comp);
@@ -152,11 +850,16 @@ namespace jul
     // Returns the min value of the vector.
     // Precondition: vector can't be empty!
     // ---------------------------------------------------------------------------------
-    template <class T>
-    T min_value(const std::vector<T>& v)
+    template <class Vector, class T = vector_value_t<Vector>>
+    T min_value(const Vector& v)
     {
         assert(std::size(v) != 0);
-        return *std::min_element(std::begin(v), std::end(v));
+        if constexpr (detail::is_reducible_v<T>) {
+            return detail::reduce_lanes(v.data(), std::size(v), [](T a, T b) { return a < b ? a : b; });
+        }
+        else {
+            return *std::min_element(std::begin(v), std::end(v));
+        }
     }
 
 
@@ -165,8 +868,8 @@ namespace jul
     // Returns the int value of the vector with a custom compare function.
     // Precondition: vector can't be empty!
     // ---------------------------------------------------------------------------------
-    template <class T, class Compare>
-    T min_value(const std::vector<T>& v, Compare&& comp)
+    template <class Vector, class Compare, class T = vector_value_t<Vector>>
+    T min_value(const Vector& v, Compare&& comp)
     {
         assert(std::size(v) != 0);
         return *std::min_element(std::begin(v), std::end(v), comp);
@@ -175,19 +878,17 @@ namespace jul
 
 
     // ---------------------------------------------------------------------------------
-    // Get a copy of all elements within limits.
+    // Get a copy of all elements within limits (see View.h for lazy chains).
     // Example:
     // std::vector<int> ints = { 0,1,0,3 };
     // auto limited = within_limits(ints, 0, 1);
     //
     // => limited = {0,1,0}
     // ---------------------------------------------------------------------------------    
-    template <class T>
-    std::vector<T> within_limits(std::vector<T> values, T min, T max)
+    template <class Vector, class T = vector_value_t<Vector>>
+    Vector within_limits(const Vector& values, vector_value_t<Vector> min, vector_value_t<Vector> max)
     {
-        auto filter = [=](T value) {return value < min || value > max;};
-        values.erase(std::remove_if(std::begin(values), std::end(values), filter), std::end(values));
-        return values;
+        return detail::filter_copy(values, detail::Within_Filter<T>{ min, max });
     }
 
 
@@ -200,12 +901,68 @@ namespace jul
     //
     // => outside = {3}
     // --------------------------------------------------------------------------------- 
-    template <class T>
-    std::vector<T> out_of_limits(std::vector<T> values, T min, T max)
+    template <class Vector, class T = vector_value_t<Vector>>
+    Vector out_of_limits(const Vector& values, vector_value_t<Vector> min, vector_value_t<Vector> max)
     {
-        auto filter = [=](T value) {return value >= min && value <= max;};
-        values.erase(std::remove_if(std::begin(values), std::end(values), filter), std::end(values));
-        return values;
+        return detail::filter_copy(values, detail::Outside_Filter<T>{ min, max });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Removes all elements outside limits, in place.
+    // Example:
+    // std::vector<int> ints = { 0,1,0,3 };
+    // keep_within_limits(ints, 0, 1);
+    //
+    // => ints = {0,1,0}
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class T = vector_value_t<Vector>>
+    void keep_within_limits(Vector& values, vector_value_t<Vector> min, vector_value_t<Vector> max)
+    {
+        detail::filter_in_place(values, detail::Within_Filter<T>{ min, max });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Removes all elements within limits, in place.
+    // Example:
+    // std::vector<int> ints = { 0,1,0,3 };
+    // keep_out_of_limits(ints, 0, 1);
+    //
+    // => ints = {3}
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class T = vector_value_t<Vector>>
+    void keep_out_of_limits(Vector& values, vector_value_t<Vector> min, vector_value_t<Vector> max)
+    {
+        detail::filter_in_place(values, detail::Outside_Filter<T>{ min, max });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Copies all elements within limits to an output iterator (like std::copy_if).
+    // Example:
+    // copy_within_limits(std::begin(ints), std::end(ints), std::back_inserter(limited), 0, 1);
+    // ---------------------------------------------------------------------------------
+    template <class InputIt, class OutputIt, class T>
+    OutputIt copy_within_limits(InputIt first, InputIt last, OutputIt out, T min, T max)
+    {
+        const detail::Within_Filter<T> filter{ min, max };
+        return std::copy_if(first, last, out, [&](const T& value) { return filter.keep(value); });
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Copies all elements outside limits to an output iterator (like std::copy_if).
+    // ---------------------------------------------------------------------------------
+    template <class InputIt, class OutputIt, class T>
+    OutputIt copy_out_of_limits(InputIt first, InputIt last, OutputIt out, T min, T max)
+    {
+        const detail::Outside_Filter<T> filter{ min, max };
+        return std::copy_if(first, last, out, [&](const T& value) { return filter.keep(value); });
     }
     
     
@@ -249,17 +1006,22 @@ namespace jul
 
     
     // ---------------------------------------------------------------------------------
-    // Calculate the mean value of some values.
+    // Calculate the mean value of some values. Sums up in double, so small integer
+    // types can't overflow.
     // ---------------------------------------------------------------------------------
-    template <class T>
-    double mean(const std::vector<T>& values)
+    template <class Vector, class T = vector_value_t<Vector>>
+    double mean(const Vector& values)
     {
-        auto beg = std::begin(values);
-        auto end = std::end(values);
-        assert(beg != end && "Calculation of mean is not possible on empty range!");
+        assert(!values.empty() && "Calculation of mean is not possible on empty range!");
 
-        const double sum   = static_cast<double>(std::accumulate(beg, end, T {0}));
-        const double count = std::size(values);
+        double sum = 0.0;
+        if constexpr (detail::is_reducible_v<T>) {
+            sum = detail::sum(values.data(), std::size(values));
+        }
+        else {
+            sum = std::accumulate(std::begin(values), std::end(values), 0.0);
+        }
+        const double count = static_cast<double>(std::size(values));
 
         return sum / count;
     }
@@ -267,18 +1029,232 @@ namespace jul
 
 
     // ---------------------------------------------------------------------------------
-    // Calculate the standard_deviation of some values.
+    // Statistics of a range, see jul::stats.
+    // variance is the sample variance (divided by count - 1), 0 for a single value.
     // ---------------------------------------------------------------------------------
     template <class T>
-    double standard_deviation(const std::vector<T>& values)
+    struct Stats {
+        std::size_t count    = 0;
+        T           min      = {};
+        T           max      = {};
+        double      mean     = 0.0;
+        double      variance = 0.0;
+
+        double standard_deviation() const { return std::sqrt(variance); }
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Stats_Accumulator (class): streaming statistics (count, mean, M2, min, max).
+    // Values can be pushed one by one (Welford), accumulators of different threads
+    // or stream segments can be merged (Chan et al.). No samples are stored.
+    // Example:
+    // Stats_Accumulator<double> latency;
+    // for (auto sample : stream) { latency.push(sample); }
+    // auto s = latency.stats();
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    class Stats_Accumulator {
+    public:
+
+        Stats_Accumulator() = default;
+        Stats_Accumulator(std::size_t count, double mean, double m2, T min, T max) :
+            m_count{ count }, m_mean{ mean }, m_m2{ m2 }, m_min{ min }, m_max{ max }
+        {}
+
+        void push(T value)
+        {
+            if (m_count == 0) {
+                m_min = value;
+                m_max = value;
+            }
+            else {
+                m_min = value < m_min ? value : m_min;
+                m_max = value > m_max ? value : m_max;
+            }
+
+            m_count++;
+            const double delta = static_cast<double>(value) - m_mean;
+            m_mean += delta / static_cast<double>(m_count);
+            m_m2   += delta * (static_cast<double>(value) - m_mean);
+        }
+
+        void merge(const Stats_Accumulator& other)
+        {
+            if (other.m_count == 0) return;
+            if (m_count == 0) {
+                *this = other;
+                return;
+            }
+
+            const double count_a = static_cast<double>(m_count);
+            const double count_b = static_cast<double>(other.m_count);
+            const double total   = count_a + count_b;
+            const double delta   = other.m_mean - m_mean;
+
+            m_mean  += delta * count_b / total;
+            m_m2    += other.m_m2 + delta * delta * count_a * count_b / total;
+            m_count += other.m_count;
+            m_min    = other.m_min < m_min ? other.m_min : m_min;
+            m_max    = other.m_max > m_max ? other.m_max : m_max;
+        }
+
+        std::size_t count() const { return m_count; }
+        double      mean()  const { return m_mean; }
+        T           min()   const { return m_min; }
+        T           max()   const { return m_max; }
+
+        // sample variance, 0 for less than two values
+        double variance() const { return m_count > 1 ? m_m2 / static_cast<double>(m_count - 1) : 0.0; }
+
+        Stats<T> stats() const { return { m_count, m_min, m_max, m_mean, variance() }; }
+
+    private:
+        std::size_t m_count = 0;
+        double      m_mean  = 0.0;
+        double      m_m2    = 0.0;
+        T           m_min   = {};
+        T           m_max   = {};
+    };
+
+
+
+    namespace detail {
+
+        // Stats of at most Stats_Block_Size values in a single vectorizable pass. The values
+        // are summed relative to the first one, which keeps the sum of squares well conditioned.
+        template <class T>
+        Stats_Accumulator<T> block_stats(const T* data, std::size_t size)
+        {
+            constexpr std::size_t L = Reduce_Lanes;
+
+            const double shift = static_cast<double>(data[0]);
+
+            T lane_min[L];
+            T lane_max[L];
+            std::fill(std::begin(lane_min), std::end(lane_min), data[0]);
+            std::fill(std::begin(lane_max), std::end(lane_max), data[0]);
+
+            double s1[L] = {};
+            double s2[L] = {};
+
+            std::size_t n = 0;
+            for (; n + L <= size; n += L) {
+                for (std::size_t l = 0; l < L; ++l) {
+                    const T      value = data[n + l];
+                    const double d     = static_cast<double>(value) - shift;
+                    s1[l] += d;
+                    s2[l] += d * d;
+                    lane_min[l] = value < lane_min[l] ? value : lane_min[l];
+                    lane_max[l] = value > lane_max[l] ? value : lane_max[l];
+                }
+            }
+            for (; n < size; ++n) {
+                const T      value = data[n];
+                const double d     = static_cast<double>(value) - shift;
+                s1[0] += d;
+                s2[0] += d * d;
+                lane_min[0] = value < lane_min[0] ? value : lane_min[0];
+                lane_max[0] = value > lane_max[0] ? value : lane_max[0];
+            }
+
+            const double count = static_cast<double>(size);
+            const double sum1  = std::accumulate(std::begin(s1), std::end(s1), 0.0);
+            const double sum2  = std::accumulate(std::begin(s2), std::end(s2), 0.0);
+
+            return {
+                size,
+                shift + sum1 / count,
+                std::max(0.0, sum2 - sum1 * sum1 / count),
+                *std::min_element(std::begin(lane_min), std::end(lane_min)),
+                *std::max_element(std::begin(lane_max), std::end(lane_max))
+            };
+        }
+
+        template <class T>
+        Stats_Accumulator<T> range_stats(const T* data, std::size_t size)
+        {
+            Stats_Accumulator<T> result;
+            for (std::size_t first = 0; first < size; first += Stats_Block_Size) {
+                result.merge(block_stats(data + first, std::min(Stats_Block_Size, size - first)));
+            }
+            return result;
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Calculate count, min, max, mean and variance in a single pass.
+    // Precondition: vector can't be empty!
+    // Example:
+    // auto s = stats(std::vector<int>{ 1, 2, 3, 4 });
+    // => s.count = 4, s.min = 1, s.max = 4, s.mean = 2.5, s.variance = 1.666..
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class T = vector_value_t<Vector>>
+    Stats<T> stats(const Vector& values)
     {
-        const double m = mean(values);
-        double sum = 0.0;
-        std::for_each(std::begin(values), std::end(values), [&](const double d) {
-            sum += (d - m) * (d - m);
-        });
+        static_assert(std::is_arithmetic<T>::value, "stats needs an arithmetic type!");
+        assert(!values.empty() && "Calculation of stats is not possible on empty range!");
 
-        return static_cast<double>(sqrt(sum / (values.size() - 1)));
+        if constexpr (detail::is_reducible_v<T>) {
+            return detail::range_stats(values.data(), std::size(values)).stats();
+        }
+        else {
+            Stats_Accumulator<T> result;
+            for (const T value : values) { result.push(value); }
+            return result.stats();
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Same as stats, but every hardware thread reduces a chunk of the vector
+    // and the partial results are merged. Sequential below jul::parallel_threshold.
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class T = vector_value_t<Vector>>
+    Stats<T> parallel_stats(const Vector& values)
+    {
+        static_assert(std::is_arithmetic<T>::value, "stats needs an arithmetic type!");
+        assert(!values.empty() && "Calculation of stats is not possible on empty range!");
+
+        if constexpr (!detail::is_reducible_v<T>) {
+            return stats(values); // chunks of a std::vector<bool> can't be addressed through data()
+        }
+        else {
+            const std::size_t size = std::size(values);
+            if (size < parallel_threshold) {
+                return stats(values);
+            }
+
+            const std::size_t chunks = hardware_threads();
+            std::vector<std::size_t> chunk_index(chunks);
+            std::iota(std::begin(chunk_index), std::end(chunk_index), std::size_t{ 0 });
+
+            const auto merged = std::transform_reduce(std::execution::par,
+                std::begin(chunk_index), std::end(chunk_index), Stats_Accumulator<T>{},
+                [](Stats_Accumulator<T> a, const Stats_Accumulator<T>& b) { a.merge(b); return a; },
+                [&](std::size_t n) {
+                    const std::size_t first = size * n / chunks;
+                    const std::size_t last  = size * (n + 1) / chunks;
+                    return detail::range_stats(values.data() + first, last - first);
+                });
+
+            return merged.stats();
+        }
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Calculate the standard_deviation of some values (single pass, see jul::stats).
+    // ---------------------------------------------------------------------------------
+    template <class Vector, class = vector_value_t<Vector>>
+    double standard_deviation(const Vector& values)
+    {
+        return stats(values).standard_deviation();
     }
 
 }
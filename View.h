@@ -0,0 +1,405 @@
+#ifndef JUL_VIEW_H
+#define JUL_VIEW_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// -------------------------------------------------------------------
+// Lazy views (a small C++17 subset of std::ranges).
+// A chain of views does no work until it is iterated, every element
+// passes the whole chain in one go and no temporary vectors are
+// created. to_vector() materializes a chain with one allocation.
+//
+// Example:
+// auto names = records
+//            | filter([](const Record& r) { return r.valid; })
+//            | transform([](const Record& r) { return r.name; })
+//            | to_vector();
+//
+// A view of an lvalue container only refers to it, the container
+// must outlive the view. Rvalue containers are moved into the view.
+// -------------------------------------------------------------------
+namespace jul {
+
+    // base class of all views, views are cheap to copy
+    struct View_Base {};
+
+    template <class T>
+    inline constexpr bool is_view_v = std::is_base_of<View_Base, std::decay_t<T>>::value;
+
+
+
+    namespace detail {
+
+        template <class Range>
+        using iterator_t = decltype(std::begin(std::declval<Range&>()));
+
+        template <class Range, class = void>
+        struct has_size : std::false_type {};
+
+        template <class Range>
+        struct has_size<Range, std::void_t<decltype(std::size(std::declval<const Range&>()))>> : std::true_type {};
+
+        template <class Range, class = void>
+        struct has_size_hint : std::false_type {};
+
+        template <class Range>
+        struct has_size_hint<Range, std::void_t<decltype(std::declval<const Range&>().size_hint())>> : std::true_type {};
+
+        // exact size if known, else an upper bound (or 0 if there is none)
+        template <class Range>
+        std::size_t size_hint(const Range& range)
+        {
+            if constexpr (has_size<Range>::value) {
+                return static_cast<std::size_t>(std::size(range));
+            }
+            else if constexpr (has_size_hint<Range>::value) {
+                return range.size_hint();
+            }
+            else {
+                return 0;
+            }
+        }
+
+        template <class Reference>
+        using iterator_category_for = std::conditional_t<std::is_reference<Reference>::value, std::forward_iterator_tag, std::input_iterator_tag>;
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Ref_View (class): view of an lvalue container (stores a pointer).
+    // ---------------------------------------------------------------------------------
+    template <class Range>
+    class Ref_View : public View_Base {
+    public:
+        explicit Ref_View(Range& range) : m_range{ &range } {}
+
+        auto begin() const { return std::begin(*m_range); }
+        auto end()   const { return std::end(*m_range); }
+
+        template <class R = Range, class = std::enable_if_t<detail::has_size<R>::value>>
+        std::size_t size() const { return static_cast<std::size_t>(std::size(*m_range)); }
+
+    private:
+        Range* m_range;
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Owning_View (class): view that owns a container moved into it.
+    // ---------------------------------------------------------------------------------
+    template <class Range>
+    class Owning_View : public View_Base {
+    public:
+        explicit Owning_View(Range&& range) : m_range{ std::move(range) } {}
+
+        auto begin() const { return std::begin(m_range); }
+        auto end()   const { return std::end(m_range); }
+
+        template <class R = Range, class = std::enable_if_t<detail::has_size<R>::value>>
+        std::size_t size() const { return static_cast<std::size_t>(std::size(m_range)); }
+
+    private:
+        Range m_range;
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Turns a container into a view, views are returned as they are.
+    // ---------------------------------------------------------------------------------
+    template <class Range>
+    auto as_view(Range&& range)
+    {
+        if constexpr (is_view_v<Range>) {
+            return std::decay_t<Range>(std::forward<Range>(range));
+        }
+        else if constexpr (std::is_lvalue_reference<Range>::value) {
+            return Ref_View<std::remove_reference_t<Range>>(range);
+        }
+        else {
+            return Owning_View<std::decay_t<Range>>(std::move(range));
+        }
+    }
+
+    template <class Range>
+    using view_t = decltype(as_view(std::declval<Range>()));
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Iota_View (class): the values [first, last) without storing them.
+    // Example:
+    // for (int i : iota(0, 4)) { ... }                 // 0, 1, 2, 3
+    // auto squares = iota(0, 4) | transform([](int i) { return i * i; }) | to_vector();
+    // => squares = { 0, 1, 4, 9 }
+    // ---------------------------------------------------------------------------------
+    template <class T>
+    class Iota_View : public View_Base {
+    public:
+        class iterator {
+        public:
+            using iterator_category = std::input_iterator_tag;
+            using value_type        = T;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using reference         = T;
+
+            iterator() = default;
+            explicit iterator(T value) : m_value{ value } {}
+
+            T operator*() const { return m_value; }
+
+            iterator& operator++()    { ++m_value; return *this; }
+            iterator  operator++(int) { auto copy = *this; ++m_value; return copy; }
+
+            bool operator==(const iterator& other) const { return m_value == other.m_value; }
+            bool operator!=(const iterator& other) const { return m_value != other.m_value; }
+
+        private:
+            T m_value = {};
+        };
+
+        Iota_View(T first, T last) : m_first{ first }, m_last{ last < first ? first : last } {}
+
+        iterator    begin() const { return iterator{ m_first }; }
+        iterator    end()   const { return iterator{ m_last }; }
+        std::size_t size()  const { return static_cast<std::size_t>(m_last - m_first); }
+
+    private:
+        T m_first;
+        T m_last;
+    };
+
+    template <class T>
+    Iota_View<T> iota(T first, T last)
+    {
+        return { first, last };
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Filter_View (class): only the elements for which pred(element) is true.
+    // The size is unknown before iterating, size_hint() is the size of the source.
+    // ---------------------------------------------------------------------------------
+    template <class View, class Predicate>
+    class Filter_View : public View_Base {
+    public:
+        using base_iterator = detail::iterator_t<const View>;
+
+        class iterator {
+        public:
+            using reference         = typename std::iterator_traits<base_iterator>::reference;
+            using value_type        = typename std::iterator_traits<base_iterator>::value_type;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using iterator_category = detail::iterator_category_for<reference>;
+
+            iterator() = default;
+            iterator(base_iterator it, base_iterator end, const Predicate* pred) :
+                m_it{ it }, m_end{ end }, m_pred{ pred }
+            {
+                skip();
+            }
+
+            reference operator*() const { return *m_it; }
+
+            iterator& operator++()    { ++m_it; skip(); return *this; }
+            iterator  operator++(int) { auto copy = *this; ++*this; return copy; }
+
+            bool operator==(const iterator& other) const { return m_it == other.m_it; }
+            bool operator!=(const iterator& other) const { return m_it != other.m_it; }
+
+        private:
+            base_iterator    m_it   = {};
+            base_iterator    m_end  = {};
+            const Predicate* m_pred = nullptr;
+
+            void skip()
+            {
+                while (m_it != m_end && !(*m_pred)(*m_it)) ++m_it;
+            }
+        };
+
+        Filter_View(View view, Predicate pred) : m_view{ std::move(view) }, m_pred{ std::move(pred) } {}
+
+        iterator    begin()     const { return { std::begin(m_view), std::end(m_view), &m_pred }; }
+        iterator    end()       const { return { std::end(m_view), std::end(m_view), &m_pred }; }
+        std::size_t size_hint() const { return detail::size_hint(m_view); }
+
+    private:
+        View      m_view;
+        Predicate m_pred;
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Transform_View (class): fn(element) for every element, computed on access.
+    // ---------------------------------------------------------------------------------
+    template <class View, class Function>
+    class Transform_View : public View_Base {
+    public:
+        using base_iterator = detail::iterator_t<const View>;
+
+        class iterator {
+        public:
+            using reference         = std::invoke_result_t<const Function&, typename std::iterator_traits<base_iterator>::reference>;
+            using value_type        = std::decay_t<reference>;
+            using difference_type   = std::ptrdiff_t;
+            using pointer           = void;
+            using iterator_category = detail::iterator_category_for<reference>;
+
+            iterator() = default;
+            iterator(base_iterator it, const Function* fn) : m_it{ it }, m_fn{ fn } {}
+
+            reference operator*() const { return std::invoke(*m_fn, *m_it); }
+
+            iterator& operator++()    { ++m_it; return *this; }
+            iterator  operator++(int) { auto copy = *this; ++m_it; return copy; }
+
+            bool operator==(const iterator& other) const { return m_it == other.m_it; }
+            bool operator!=(const iterator& other) const { return m_it != other.m_it; }
+
+        private:
+            base_iterator   m_it = {};
+            const Function* m_fn = nullptr;
+        };
+
+        Transform_View(View view, Function fn) : m_view{ std::move(view) }, m_fn{ std::move(fn) } {}
+
+        iterator begin() const { return { std::begin(m_view), &m_fn }; }
+        iterator end()   const { return { std::end(m_view), &m_fn }; }
+
+        template <class V = View, class = std::enable_if_t<detail::has_size<V>::value>>
+        std::size_t size() const { return static_cast<std::size_t>(std::size(m_view)); }
+
+        std::size_t size_hint() const { return detail::size_hint(m_view); }
+
+    private:
+        View     m_view;
+        Function m_fn;
+    };
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Adaptors for the pipe syntax: range | filter(pred) | transform(fn) | to_vector()
+    // ---------------------------------------------------------------------------------
+    template <class Predicate>
+    struct Filter_Adaptor { Predicate pred; };
+
+    template <class Function>
+    struct Transform_Adaptor { Function fn; };
+
+    struct To_Vector_Adaptor {};
+
+    template <class Predicate>
+    Filter_Adaptor<std::decay_t<Predicate>> filter(Predicate&& pred)
+    {
+        return { std::forward<Predicate>(pred) };
+    }
+
+    template <class Function>
+    Transform_Adaptor<std::decay_t<Function>> transform(Function&& fn)
+    {
+        return { std::forward<Function>(fn) };
+    }
+
+    inline To_Vector_Adaptor to_vector() { return {}; }
+
+    template <class Range, class Predicate>
+    Filter_View<view_t<Range>, Predicate> operator|(Range&& range, Filter_Adaptor<Predicate> adaptor)
+    {
+        return { as_view(std::forward<Range>(range)), std::move(adaptor.pred) };
+    }
+
+    template <class Range, class Function>
+    Transform_View<view_t<Range>, Function> operator|(Range&& range, Transform_Adaptor<Function> adaptor)
+    {
+        return { as_view(std::forward<Range>(range)), std::move(adaptor.fn) };
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Materializes a range into a vector with a single allocation: the exact size
+    // for sized views, the size of the source for filtered views.
+    // Example:
+    // auto big = values | filter([](int v) { return v > 100; }) | to_vector();
+    // auto copy = to_vector(iota(0, 10));
+    // ---------------------------------------------------------------------------------
+    template <class Range>
+    auto to_vector(const Range& range)
+    {
+        using T = std::decay_t<decltype(*std::begin(range))>;
+
+        std::vector<T> result;
+        result.reserve(detail::size_hint(range));
+        for (auto&& value : range) {
+            result.push_back(std::forward<decltype(value)>(value));
+        }
+        return result;
+    }
+
+    template <class Range>
+    auto operator|(const Range& range, To_Vector_Adaptor)
+    {
+        return to_vector(range);
+    }
+
+
+
+    // ---------------------------------------------------------------------------------
+    // Keys / values of a map (or any range of pairs) as a view.
+    // Example:
+    // std::map<int, std::string> m{ {1, "one"}, {2, "two"} };
+    // for (const auto& name : values(m)) { ... }
+    // auto ids = keys(m) | filter(is_even) | to_vector();
+    // ---------------------------------------------------------------------------------
+    template <class Map>
+    auto keys(Map&& m)
+    {
+        return std::forward<Map>(m) | transform([](const auto& kv) -> const auto& { return kv.first; });
+    }
+
+    template <class Map>
+    auto values(Map&& m)
+    {
+        return std::forward<Map>(m) | transform([](const auto& kv) -> const auto& { return kv.second; });
+    }
+}
+
+#endif // JUL_VIEW_H
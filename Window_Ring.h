@@ -0,0 +1,190 @@
+#ifndef JUL_WINDOW_RING_H
+#define JUL_WINDOW_RING_H
+
+/*
+MIT License
+
+Copyright(c) 2019 Julian Steigerwald
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files(the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and /or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions :
+
+The above copyright noticeand this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <type_traits>
+
+#include "Ring.h"
+
+namespace jul {
+
+    namespace detail {
+
+        // Monotonic deque of the last Size pushes: the front is the extreme value
+        // (min for std::less, max for std::greater) of the window, values that can
+        // never become the extreme again are dropped from the back.
+        template <class T, std::size_t Size, class Compare>
+        class Monotonic_Deque {
+        public:
+            void push(std::size_t sequence, const T& value)
+            {
+                // expired values leave at the front
+                if (m_count != 0 && m_entries[m_first].sequence + Size <= sequence) {
+                    pop_front();
+                }
+                // values that lose against the new one leave at the back
+                while (m_count != 0 && !Compare{}(back().value, value)) {
+                    --m_count;
+                }
+                m_entries[wrap(m_first + m_count)] = { sequence, value };
+                ++m_count;
+            }
+
+            const T& front() const { assert(m_count != 0); return m_entries[m_first].value; }
+
+            void clear() { m_first = 0; m_count = 0; }
+
+        private:
+            struct Entry {
+                std::size_t sequence;
+                T           value;
+            };
+
+            std::array<Entry, Size> m_entries = {};
+            std::size_t             m_first   = 0;
+            std::size_t             m_count   = 0;
+
+            static std::size_t wrap(std::size_t index) { return index >= Size ? index - Size : index; }
+
+            const Entry& back() const { return m_entries[wrap(m_first + m_count - 1)]; }
+
+            void pop_front()
+            {
+                m_first = wrap(m_first + 1);
+                --m_count;
+            }
+        };
+    }
+
+
+
+    // ---------------------------------------------------------------
+    // Window_Ring (class) = sliding window over the last Size values
+    // with O(1) aggregates.
+    // The values live in a jul::Ring. The sum is updated on every push
+    // (integers exactly, floating point values with Kahan compensation),
+    // min and max come from monotonic deques: O(1) amortized per push,
+    // no loop over the window when they are read.
+    // Example:
+    // Window_Ring<double, 64> latency;
+    // latency.push(sample);
+    // if (latency.max() > 2 * latency.mean()) { ... }
+    // ---------------------------------------------------------------
+    template <class T, std::size_t Size>
+    class Window_Ring {
+    public:
+
+        static_assert(Size > 0, "A Window_Ring of 0 is not allowed!");
+        static_assert(std::is_arithmetic<T>::value, "A Window_Ring aggregates arithmetic values!");
+
+        // member types
+        using value_type = T;
+        using size_type  = std::size_t;
+        using sum_type   = std::conditional_t<std::is_floating_point<T>::value, double,
+                           std::conditional_t<std::is_signed<T>::value, long long, unsigned long long>>;
+
+        // push a value, the oldest one leaves the window when it is full;
+        // true: a value was dropped
+        bool push(T value)
+        {
+            const bool dropping = full();
+            if (dropping) {
+                add(-static_cast<sum_type>(oldest()));
+            }
+            add(static_cast<sum_type>(value));
+
+            m_min.push(m_pushed, value);
+            m_max.push(m_pushed, value);
+            m_values.push(value);
+            ++m_pushed;
+            return dropping;
+        }
+
+        // aggregates of the window, min/max/mean need at least one value
+        sum_type sum()  const { return m_sum; }
+        double   mean() const { assert(!empty()); return static_cast<double>(m_sum) / static_cast<double>(size()); }
+        const T& min()  const { assert(!empty()); return m_min.front(); }
+        const T& max()  const { assert(!empty()); return m_max.front(); }
+
+        // the oldest and the newest value of the window
+        const T& oldest() const { assert(!empty()); return full() ? m_values.current() : m_values[0]; }
+        const T& newest() const { assert(!empty()); return m_values[(m_values.index() + Size - 1) % Size]; }
+
+        // n-th value from the oldest (0) to the newest (size() - 1)
+        const T& operator[](size_type n) const
+        {
+            assert(n < size());
+            return full() ? m_values[(m_values.index() + n) % Size] : m_values[n];
+        }
+
+        size_type size()  const { return m_pushed < Size ? m_pushed : Size; }
+        bool      empty() const { return m_pushed == 0; }
+        bool      full()  const { return m_pushed >= Size; }
+        static constexpr size_type capacity() { return Size; }
+
+        // the underlying ring (storage order)
+        const Ring<T, Size>& ring() const { return m_values; }
+
+        void clear()
+        {
+            m_values = {};
+            m_min.clear();
+            m_max.clear();
+            m_pushed     = 0;
+            m_sum        = 0;
+            m_correction = 0;
+        }
+
+    private:
+        Ring<T, Size> m_values;
+        detail::Monotonic_Deque<T, Size, std::less<>>    m_min;
+        detail::Monotonic_Deque<T, Size, std::greater<>> m_max;
+
+        size_type m_pushed     = 0;
+        sum_type  m_sum        = 0;
+        sum_type  m_correction = 0; // Kahan, floating point only
+
+        void add(sum_type value)
+        {
+            if constexpr (std::is_floating_point<sum_type>::value) {
+                const sum_type y = value - m_correction;
+                const sum_type t = m_sum + y;
+                m_correction = (t - m_sum) - y;
+                m_sum = t;
+            }
+            else {
+                m_sum += value;
+            }
+        }
+    };
+}
+
+#endif // JUL_WINDOW_RING_H